@@ -3,5 +3,7 @@
 
 #include "app/app.h"
 #include "win/win.h"
+#include "event/event.h"
+#include "element/element.h"
 
 #endif // ANGELO_H
\ No newline at end of file
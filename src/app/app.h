@@ -33,11 +33,123 @@
 typedef uintptr_t AppHandle;
 typedef OPTION(AppHandle) AppHandle_opt;
 
+typedef uintptr_t AppTimerHandle;
+typedef OPTION(AppTimerHandle) AppTimerHandle_opt;
+
+typedef void (*AppTimerCallback)(AppHandle app, AppTimerHandle timer, void* userData);
+typedef void (*AppTaskCallback)(AppHandle app, void* userData);
+
+typedef enum
+{
+    APP_BACKEND_AUTO,
+    APP_BACKEND_XORG,
+    APP_BACKEND_WAYLAND,
+    APP_BACKEND_HEADLESS
+} AppBackend;
+
+typedef enum
+{
+    /* EGL, falling back to GLX where the X server has no EGL */
+    APP_GL_API_AUTO,
+    APP_GL_API_EGL,
+    APP_GL_API_GLX
+} AppGlApi;
+
+typedef enum
+{
+    /* every window owns an independent context */
+    APP_GL_CONTEXT_PER_WINDOW,
+
+    /* every window owns a context, all in one share group so gl objects are uploaded once */
+    APP_GL_CONTEXT_SHARE_GROUP,
+
+    /* one context renders every window */
+    APP_GL_CONTEXT_SINGLE
+} AppGlContextMode;
+
+/* 
+** what window framebuffers hold. zero initialised is opaque 8-bit RGB with
+** no depth, stencil or multisampling, which is all 2D drawing needs. the
+** cheapest config providing at least what is asked for is chosen.
+*/
+typedef struct
+{
+    int depthBits;
+    int stencilBits;
+
+    /* multisample count, 0 or 1 for none */
+    int samples;
+
+    bool hasAlpha;
+
+    /* writes are converted to sRGB where GL_FRAMEBUFFER_SRGB is enabled */
+    bool isSrgb;
+} SurfaceFormat;
+
+/* a zero initialised config gives the default behaviour */
+typedef struct
+{
+    AppBackend backend;
+
+    /* render on the cpu instead of through OpenGL where the backend supports it */
+    bool softwareRendering;
+
+    AppGlContextMode glContextMode;
+
+    /* how Xorg windows reach OpenGL, Wayland and headless always use EGL */
+    AppGlApi glApi;
+
+    /* shared by every window, so contexts can move between them */
+    SurfaceFormat surfaceFormat;
+
+    /*
+    ** draw and present on a dedicated thread so slow frames never stall event
+    ** handling (Xorg and headless). it starts on the first run_app,
+    ** poll_events, wait_events or dispatch_app_pending and stops when run_app
+    ** returns.
+    */
+    bool renderThread;
+
+    /* queue every pointer motion and resize instead of only the latest per window in each dispatch pass */
+    bool keepEventHistory;
+} AppConfig;
+
 /***************************************************************
 ** MARK: FUNCTION DEFS
 ***************************************************************/
 
 AppHandle_opt create_app(const char* title);
+AppHandle_opt create_app_with_config(const char* title, AppConfig config);
 int run_app(AppHandle handle);
 
+/* 
+** for driving the app from another event loop: wait for the fd to become
+** readable or the deadline to pass, then call dispatch_app_pending. the fd
+** is -1 where the platform has none.
+*/
+int get_app_fd(AppHandle handle);
+
+/* one non-blocking run_app iteration, events are discarded (poll_events returns them instead) */
+int dispatch_app_pending(AppHandle handle);
+
+/* CLOCK_MONOTONIC nanoseconds of the next timer, 0 when work is already waiting, -1 for none */
+int64_t get_app_next_deadline(AppHandle handle);
+
+/* 
+** call back every intervalNanos on the event thread, from inside run_app or
+** the event functions. timers due in the same wakeup all fire together, and
+** missed intervals are skipped rather than replayed.
+*/
+AppTimerHandle_opt add_app_timer(AppHandle app, uint64_t intervalNanos, AppTimerCallback callback, void* userData);
+
+/* safe to call from the timer's own callback */
+void remove_app_timer(AppHandle app, AppTimerHandle timer);
+
+/* 
+** callable from any thread. the callback runs once on the event thread,
+** which is woken if it is sleeping. tasks from one thread run in the
+** order they were posted.
+*/
+bool post_app_task(AppHandle app, AppTaskCallback callback, void* userData);
+
 #endif /* APP_H */
\ No newline at end of file
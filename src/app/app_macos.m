@@ -19,6 +19,7 @@
 #include "app.h"
 
 #include "../debug/debug.h"
+#include "../event/event.h"
 
 #import <AppKit/AppKit.h>
 
@@ -54,6 +55,12 @@ AppHandle_opt create_app(const char* title)
     return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
 }
 
+AppHandle_opt create_app_with_config(const char* title, AppConfig config)
+{
+    /* there is only one backend on this platform */
+    return create_app(title);
+}
+
 int run_app(AppHandle handle)
 {   
     NSApplication *app = (NSApplication*)handle;
@@ -66,6 +73,63 @@ int run_app(AppHandle handle)
     return 0;
 }
 
+int get_app_fd(AppHandle handle)
+{
+    /* the cocoa run loop can't be waited on as an fd */
+    return -1;
+}
+
+int dispatch_app_pending(AppHandle handle)
+{
+    AngeloEvent events[1];
+    poll_events(handle, events, 0);
+
+    return 0;
+}
+
+int64_t get_app_next_deadline(AppHandle handle)
+{
+    return -1;
+}
+
+AppTimerHandle_opt add_app_timer(AppHandle handle, uint64_t intervalNanos, AppTimerCallback callback, void* userData)
+{
+    log_error("Timers are not supported on this platform yet");
+    return (AppTimerHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+}
+
+void remove_app_timer(AppHandle handle, AppTimerHandle timer)
+{
+}
+
+bool post_app_task(AppHandle handle, AppTaskCallback callback, void* userData)
+{
+    log_error("Task posting is not supported on this platform yet");
+    return false;
+}
+
+size_t poll_events(AppHandle handle, AngeloEvent* events, size_t capacity)
+{
+    return wait_events(handle, events, capacity, 0);
+}
+
+size_t wait_events(AppHandle handle, AngeloEvent* events, size_t capacity, int timeout)
+{
+    NSApplication *app = (NSApplication*)handle;
+
+    /* cocoa events still reach their windows, none are translated yet */
+    NSDate* deadline = timeout < 0 ? [NSDate distantFuture] : [NSDate dateWithTimeIntervalSinceNow:timeout / 1000.0];
+    NSEvent* event = [app nextEventMatchingMask:NSEventMaskAny untilDate:deadline inMode:NSDefaultRunLoopMode dequeue:YES];
+
+    while (event != nil)
+    {
+        [app sendEvent:event];
+        event = [app nextEventMatchingMask:NSEventMaskAny untilDate:[NSDate distantPast] inMode:NSDefaultRunLoopMode dequeue:YES];
+    }
+
+    return 0;
+}
+
 /***************************************************************
 ** MARK: STATIC FUNCTIONS
 ***************************************************************/
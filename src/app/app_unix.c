@@ -18,22 +18,44 @@
 
 #include "app.h"
 #include "app_unix.h"
+#include "timer_unix.h"
+#include "task_unix.h"
 
 #include "../debug/debug.h"
 #include "../win/win.h" 
 #include "../win/win_unix.h"
+#include "../render/render_unix.h"
 
 #include <stdlib.h> 
 #include <string.h>
+#include <errno.h>
+#include <EGL/eglext.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <linux/input-event-codes.h>
 
 /***************************************************************
 ** MARK: CONSTANTS & MACROS
 ***************************************************************/
 
+#define MAX_EPOLL_EVENTS 8
+
 /***************************************************************
 ** MARK: TYPEDEFS
 ***************************************************************/
 
+/* what a GLX or EGL config provides, for scoring against a SurfaceFormat */
+typedef struct
+{
+    int colorBits;
+    int alphaBits;
+    int depthBits;
+    int stencilBits;
+    int samples;
+    bool isSrgbCapable;
+    bool isSlow;
+} ConfigTraits;
+
 /***************************************************************
 ** MARK: STATIC VARIABLES
 ***************************************************************/
@@ -48,79 +70,267 @@ static int visual_attribs[] = {
     GLX_RED_SIZE, 8,
     GLX_GREEN_SIZE, 8,
     GLX_BLUE_SIZE, 8,
-    GLX_ALPHA_SIZE, 8,
-    GLX_DEPTH_SIZE, 24,
-    GLX_STENCIL_SIZE, 8,
     GLX_DOUBLEBUFFER, True,
     None
 };
 
+static EGLint egl_config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_NONE
+};
+
+static EGLint egl_pbuffer_config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_NONE
+};
+
+static void handle_registry_global(void* data, struct wl_registry* registry, uint32_t name, const char* interface, uint32_t version);
+static void handle_registry_global_remove(void* data, struct wl_registry* registry, uint32_t name);
+static void handle_wm_base_ping(void* data, struct xdg_wm_base* wmBase, uint32_t serial);
+static void handle_seat_capabilities(void* data, struct wl_seat* seat, uint32_t capabilities);
+static void handle_seat_name(void* data, struct wl_seat* seat, const char* name);
+static void handle_pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial, struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y);
+static void handle_pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial, struct wl_surface* surface);
+static void handle_pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+static void handle_pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
+static void handle_pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+static void handle_pointer_frame(void* data, struct wl_pointer* pointer);
+static void handle_pointer_axis_source(void* data, struct wl_pointer* pointer, uint32_t source);
+static void handle_pointer_axis_stop(void* data, struct wl_pointer* pointer, uint32_t time, uint32_t axis);
+static void handle_pointer_axis_discrete(void* data, struct wl_pointer* pointer, uint32_t axis, int32_t discrete);
+static void handle_keyboard_keymap(void* data, struct wl_keyboard* keyboard, uint32_t format, int32_t fd, uint32_t size);
+static void handle_keyboard_enter(void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface, struct wl_array* keys);
+static void handle_keyboard_leave(void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface);
+static void handle_keyboard_key(void* data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
+static void handle_keyboard_modifiers(void* data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
+static void handle_keyboard_repeat_info(void* data, struct wl_keyboard* keyboard, int32_t rate, int32_t delay);
+
+static const struct wl_registry_listener registry_listener = {
+    .global = handle_registry_global,
+    .global_remove = handle_registry_global_remove
+};
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+    .ping = handle_wm_base_ping
+};
+
+static const struct wl_seat_listener seat_listener = {
+    .capabilities = handle_seat_capabilities,
+    .name = handle_seat_name
+};
+
+static const struct wl_pointer_listener pointer_listener = {
+    .enter = handle_pointer_enter,
+    .leave = handle_pointer_leave,
+    .motion = handle_pointer_motion,
+    .button = handle_pointer_button,
+    .axis = handle_pointer_axis,
+    .frame = handle_pointer_frame,
+    .axis_source = handle_pointer_axis_source,
+    .axis_stop = handle_pointer_axis_stop,
+    .axis_discrete = handle_pointer_axis_discrete
+};
+
+static const struct wl_keyboard_listener keyboard_listener = {
+    .keymap = handle_keyboard_keymap,
+    .enter = handle_keyboard_enter,
+    .leave = handle_keyboard_leave,
+    .key = handle_keyboard_key,
+    .modifiers = handle_keyboard_modifiers,
+    .repeat_info = handle_keyboard_repeat_info
+};
+
 
 /***************************************************************
 ** MARK: STATIC FUNCTION DEFS
 ***************************************************************/
 
+static AppHandle_opt create_xorg_app(const char* title, AppConfig config);
+static AppHandle_opt create_wayland_app(const char* title, AppConfig config);
+static void destroy_wayland_app(UnixApp* app);
+static AppHandle_opt create_headless_app(const char* title, AppConfig config);
+
+static bool has_extension(const char* extensions, const char* name);
+static bool init_egl(UnixEglData* egl, EGLDisplay display, const EGLint* configAttribs, SurfaceFormat format);
+static void load_egl_extensions(UnixEglData* egl);
+static bool choose_egl_config(UnixEglData* egl, const EGLint* configAttribs, SurfaceFormat format);
+static XVisualInfo* choose_xorg_egl_visual(Display* display, UnixEglData* egl, SurfaceFormat format);
+static XVisualInfo* choose_xorg_image_visual(Display* display);
+static GLXFBConfig choose_glx_config(Display* display, SurfaceFormat format);
+static int score_config(SurfaceFormat format, ConfigTraits traits);
+static int create_epoll(int displayFd);
+static int wait_for_events(UnixApp* app, int timeout);
+static int dispatch_app(UnixApp* app, int timeout);
+
+static void process_xorg_events(UnixApp* app);
+static void process_xorg_event(UnixApp* app, XEvent* event);
+static void release_wayland_pointer(UnixApp* app);
+static void release_wayland_keyboard(UnixApp* app);
+static uint32_t translate_wayland_button(uint32_t button);
+static void start_configured_render_thread(UnixApp* app);
+static void render_windows(UnixApp* app);
+
+static size_t hash_window_key(uintptr_t key, size_t slotCapacity);
+static bool grow_window_slots(UnixApp* app);
+
 /***************************************************************
 ** MARK: PUBLIC FUNCTIONS
 ***************************************************************/
 
 AppHandle_opt create_app(const char* title)
+{
+    return create_app_with_config(title, (AppConfig) { 0 });
+}
+
+AppHandle_opt create_app_with_config(const char* title, AppConfig config)
 {
     log_info("App created");
 
-    /* check for x display */
-    Display* xDisplay = XOpenDisplay(NULL);
-    if (xDisplay != NULL)
+    if (config.backend == APP_BACKEND_HEADLESS)
     {
-        log_info("Xorg environment detected");
+        return create_headless_app(title, config);
+    }
 
-        /* initialise xorg */
+    /* prefer a native wayland session so we don't go through XWayland */
+    if (config.backend == APP_BACKEND_WAYLAND || (config.backend == APP_BACKEND_AUTO && getenv("WAYLAND_DISPLAY") != NULL))
+    {
+        AppHandle_opt app = create_wayland_app(title, config);
+        if (app.is_some || config.backend == APP_BACKEND_WAYLAND)
+        {
+            return app;
+        }
 
-        /* try to chose a framebuffer */
-        int fbcount;
-        GLXFBConfig *fbc = glXChooseFBConfig(xDisplay, DefaultScreen(xDisplay), visual_attribs, &fbcount);
-        if (!fbc) {
-            log_error("Failed to retrieve a framebuffer config");
-            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        log_warn("Failed to initialise Wayland, falling back to Xorg");
+    }
+
+    AppHandle_opt app = create_xorg_app(title, config);
+    if (app.is_some)
+    {
+        return app;
+    }
+
+    log_error("Failed to find a Wayland or Xorg environment");
+
+    return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+}
+
+bool register_window(UnixApp* app, uintptr_t key, UnixWindow* window)
+{
+    UnixWindowRegistry* registry = &app->registry;
+
+    /* keep the table at most half full so probe sequences stay short */
+    if ((registry->count + 1) * 2 > registry->slotCapacity && !grow_window_slots(app))
+    {
+        log_error("Failed to grow the window registry");
+        return false;
+    }
+
+    if (registry->count == registry->capacity)
+    {
+        size_t capacity = registry->capacity == 0 ? 8 : registry->capacity * 2;
+        UnixWindow** windows = realloc(registry->windows, capacity * sizeof(UnixWindow*));
+        if (windows == NULL)
+        {
+            log_error("Failed to grow the window registry");
+            return false;
         }
 
-        /* Pick the first matching FB config */
-        GLXFBConfig bestFbc = fbc[0];
-        XFree(fbc);
+        registry->windows = windows;
+        registry->capacity = capacity;
+    }
 
-        /* get a visual */
-        XVisualInfo *vi = glXGetVisualFromFBConfig(xDisplay, bestFbc);
-        if (!vi) {
-            log_error("Failed to get a visual");
-            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    size_t index = hash_window_key(key, registry->slotCapacity);
+    while (registry->slots[index].key != 0)
+    {
+        index = (index + 1) & (registry->slotCapacity - 1);
+    }
+
+    registry->slots[index] = (UnixWindowSlot) { .key = key, .window = window };
+
+    window->registryKey = key;
+    window->registryIndex = registry->count;
+    registry->windows[registry->count++] = window;
+
+    return true;
+}
+
+void unregister_window(UnixApp* app, UnixWindow* window)
+{
+    UnixWindowRegistry* registry = &app->registry;
+
+    if (registry->slotCapacity == 0 || window->registryKey == 0)
+    {
+        return;
+    }
+
+    size_t mask = registry->slotCapacity - 1;
+    size_t index = hash_window_key(window->registryKey, registry->slotCapacity);
+
+    while (registry->slots[index].window != window)
+    {
+        if (registry->slots[index].key == 0)
+        {
+            return;
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    /* backward shift deletion keeps lookups free of tombstones */
+    size_t next = (index + 1) & mask;
+    while (registry->slots[next].key != 0)
+    {
+        size_t home = hash_window_key(registry->slots[next].key, registry->slotCapacity);
+
+        /* move the entry back if the hole lies between its home slot and where it sits now */
+        if (((next - home) & mask) >= ((next - index) & mask))
+        {
+            registry->slots[index] = registry->slots[next];
+            index = next;
         }
 
-        /* Create a colormap */
-        Colormap colormap = XCreateColormap(xDisplay, RootWindow(xDisplay, vi->screen), vi->visual, AllocNone);
-        XSetWindowAttributes windowAttributes;
-        windowAttributes.colormap = colormap;
-        windowAttributes.event_mask = ExposureMask | KeyPressMask;
+        next = (next + 1) & mask;
+    }
+
+    registry->slots[index] = (UnixWindowSlot) { 0 };
 
+    /* swap the last window into the freed dense slot */
+    UnixWindow* last = registry->windows[--registry->count];
+    registry->windows[window->registryIndex] = last;
+    last->registryIndex = window->registryIndex;
 
+    window->registryKey = 0;
+}
 
-        UnixApp *app = malloc(sizeof(UnixApp));
-        app->title = title;
-        app->appType = UNIX_APP_XORG;
-        app->data.xorgData.display = xDisplay;
-        app->data.xorgData.screen = DefaultScreen(xDisplay);
-        app->data.xorgData.root = RootWindow(xDisplay, app->data.xorgData.screen);
-        app->data.xorgData.bestFbc = bestFbc;
-        app->data.xorgData.visualInfo = vi;
-        app->data.xorgData.colormap = colormap;
-        app->data.xorgData.windowAttributes = windowAttributes;
+UnixWindow* find_window(UnixApp* app, uintptr_t key)
+{
+    UnixWindowRegistry* registry = &app->registry;
 
-        return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
+    if (registry->slotCapacity == 0 || key == 0)
+    {
+        return NULL;
     }
 
-    log_error("Failed to find an Xorg environment");
+    size_t index = hash_window_key(key, registry->slotCapacity);
+    while (registry->slots[index].key != 0)
+    {
+        if (registry->slots[index].key == key)
+        {
+            return registry->slots[index].window;
+        }
 
-    return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        index = (index + 1) & (registry->slotCapacity - 1);
+    }
 
+    return NULL;
 }
 
 int run_app(AppHandle handle)
@@ -134,29 +344,1401 @@ int run_app(AppHandle handle)
         return -1;
     }
 
-    if (app->appType == UNIX_APP_XORG)
+    if (app->appType == UNIX_APP_HEADLESS)
     {
-        while (true)
+        /* only timers and posted tasks wake a headless app, so it stops once everything is drawn and none are left */
+        do
         {
-            XEvent event;
-            /*while (XPending(app->display)) {
-                XNextEvent(app->display, &event);
-                clear_window(handle, app->windowHandle);
-                swap_window_buffers(handle, app->windowHandle);
-            }*/
+            app->eventQueue.count = 0;
+
+            /* without timers only a task already posted could wake the wait, so don't block on nothing */
+            if (dispatch_app(app, get_next_timer_deadline(app) >= 0 ? -1 : 0) < 0)
+            {
+                stop_render_thread(app);
+                return -1;
+            }
+        } while (get_next_timer_deadline(app) >= 0 || has_posted_tasks(app));
 
-            clear_window(handle, app->windowHandle);
-            swap_window_buffers(handle, app->windowHandle);
+        stop_render_thread(app);
+
+        log_info("App stopped");
+
+        return 0;
+    }
+
+    start_configured_render_thread(app);
+
+    while (app->registry.count > 0)
+    {
+        /* nobody reads the event queue while run_app drives the app */
+        app->eventQueue.count = 0;
+
+        if (dispatch_app(app, -1) < 0)
+        {
+            stop_render_thread(app);
+            return -1;
         }
     }
 
-    
+    stop_render_thread(app);
 
     log_info("App stopped");
 
     return 0;
 }
 
+int get_app_fd(AppHandle handle)
+{
+    UnixApp *app = (UnixApp*)handle;
+
+    if (app == NULL)
+    {
+        log_error("Invalid app handle");
+        return -1;
+    }
+
+    /* the display, timers, tasks and the render thread all wake this one set */
+    return app->epollFd;
+}
+
+int dispatch_app_pending(AppHandle handle)
+{
+    UnixApp *app = (UnixApp*)handle;
+
+    if (app == NULL)
+    {
+        log_error("Invalid app handle");
+        return -1;
+    }
+
+    app->eventQueue.count = 0;
+
+    return dispatch_app(app, 0);
+}
+
+int64_t get_app_next_deadline(AppHandle handle)
+{
+    UnixApp *app = (UnixApp*)handle;
+
+    if (app == NULL)
+    {
+        log_error("Invalid app handle");
+        return -1;
+    }
+
+    /* Xlib may already have read events off the fd, so it won't wake the caller for them */
+    if (app->appType == UNIX_APP_XORG && XQLength(app->data.xorgData.display) > 0)
+    {
+        return 0;
+    }
+
+    /* the same holds for events libwayland has queued but not yet dispatched */
+    if (app->appType == UNIX_APP_WAYLAND)
+    {
+        struct wl_display* display = app->data.waylandData.display;
+
+        if (wl_display_prepare_read(display) != 0)
+        {
+            return 0;
+        }
+
+        wl_display_cancel_read(display);
+    }
+
+    /* damage from the host's own invalidations is only drawn by a dispatch */
+    if (app->renderThread == NULL)
+    {
+        for (size_t i = 0; i < app->registry.count; i++)
+        {
+            UnixWindow* window = app->registry.windows[i];
+
+            if (window->needsRedraw && is_window_ready_for_frame(window))
+            {
+                return 0;
+            }
+        }
+    }
+    else if (app->renderThread->hasUnflushedMessages)
+    {
+        return 0;
+    }
+
+    return get_next_timer_deadline(app);
+}
+
+size_t poll_events(AppHandle handle, AngeloEvent* events, size_t capacity)
+{
+    return wait_events(handle, events, capacity, 0);
+}
+
+size_t wait_events(AppHandle handle, AngeloEvent* events, size_t capacity, int timeout)
+{
+    UnixApp *app = (UnixApp*)handle;
+
+    if (app == NULL || (events == NULL && capacity > 0))
+    {
+        log_error("Invalid app handle or event array");
+        return 0;
+    }
+
+    dispatch_app(app, timeout);
+
+    UnixEventQueue* queue = &app->eventQueue;
+
+    size_t count = queue->count < capacity ? queue->count : capacity;
+    size_t first = UNIX_APP_EVENT_CAPACITY - queue->head;
+    first = first < count ? first : count;
+
+    /* the ring wraps at most once */
+    memcpy(events, &queue->events[queue->head], first * sizeof(AngeloEvent));
+    memcpy(events + first, &queue->events[0], (count - first) * sizeof(AngeloEvent));
+
+    queue->head = (queue->head + count) & (UNIX_APP_EVENT_CAPACITY - 1);
+    queue->count -= count;
+
+    return count;
+}
+
+void push_app_event(UnixApp* app, AngeloEvent event)
+{
+    UnixEventQueue* queue = &app->eventQueue;
+    UnixWindow* window = (UnixWindow*)event.window;
+
+    uint64_t* pendingSeq = NULL;
+    if (window != NULL && !app->config.keepEventHistory)
+    {
+        if (event.type == ANGELO_EVENT_POINTER_MOTION)
+        {
+            pendingSeq = &window->motionEventSeq;
+        }
+        else
+        {
+            /* motion on either side of a click, key or anything else must stay in order */
+            window->motionEventSeq = 0;
+
+            if (event.type == ANGELO_EVENT_WINDOW_RESIZE)
+            {
+                pendingSeq = &window->resizeEventSeq;
+            }
+        }
+    }
+
+    /* an event queued earlier in this pass is still in the ring, so just update it */
+    if (pendingSeq != NULL && *pendingSeq > queue->passStart)
+    {
+        uint64_t oldest = queue->pushCount - queue->count;
+        queue->events[(queue->head + (size_t)(*pendingSeq - 1 - oldest)) & (UNIX_APP_EVENT_CAPACITY - 1)] = event;
+        return;
+    }
+
+    if (queue->count == UNIX_APP_EVENT_CAPACITY)
+    {
+        log_warn("Event queue full, dropping event");
+        return;
+    }
+
+    queue->events[(queue->head + queue->count) & (UNIX_APP_EVENT_CAPACITY - 1)] = event;
+    queue->count++;
+    queue->pushCount++;
+
+    if (pendingSeq != NULL)
+    {
+        *pendingSeq = queue->pushCount;
+    }
+}
+
 /***************************************************************
 ** MARK: STATIC FUNCTIONS
 ***************************************************************/
+
+static AppHandle_opt create_xorg_app(const char* title, AppConfig config)
+{
+    /* the render thread presents through the same connection the event loop reads */
+    if (config.renderThread)
+    {
+        XInitThreads();
+    }
+
+    /* check for x display */
+    Display* xDisplay = XOpenDisplay(NULL);
+    if (xDisplay == NULL)
+    {
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    log_info("Xorg environment detected");
+
+    UnixEglData egl = { .display = EGL_NO_DISPLAY, .sharedContext = EGL_NO_CONTEXT };
+    GLXFBConfig bestFbc = NULL;
+    XVisualInfo *vi = NULL;
+
+    if (config.softwareRendering)
+    {
+        /* windows are drawn on the cpu and put as images, so the default visual is all we need */
+        vi = choose_xorg_image_visual(xDisplay);
+        if (vi == NULL)
+        {
+            XCloseDisplay(xDisplay);
+            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+    }
+    else if (config.glApi != APP_GL_API_GLX)
+    {
+        vi = choose_xorg_egl_visual(xDisplay, &egl, config.surfaceFormat);
+
+        if (vi == NULL && config.glApi == APP_GL_API_EGL)
+        {
+            XCloseDisplay(xDisplay);
+            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+
+        if (vi == NULL)
+        {
+            log_warn("EGL is unavailable on this X server, falling back to GLX");
+        }
+    }
+
+    if (vi == NULL)
+    {
+        bestFbc = choose_glx_config(xDisplay, config.surfaceFormat);
+        if (!bestFbc) {
+            log_error("Failed to retrieve a framebuffer config");
+            XCloseDisplay(xDisplay);
+            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+
+        /* get a visual */
+        vi = glXGetVisualFromFBConfig(xDisplay, bestFbc);
+        if (!vi) {
+            log_error("Failed to get a visual");
+            XCloseDisplay(xDisplay);
+            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+    }
+
+    /* Create a colormap */
+    Colormap colormap = XCreateColormap(xDisplay, RootWindow(xDisplay, vi->screen), vi->visual, AllocNone);
+
+    /* the extension string must be checked, the proc addresses resolve whether or not they are supported. egl and software windows use none of them */
+    const char* glxExtensions = egl.display == EGL_NO_DISPLAY && !config.softwareRendering ? glXQueryExtensionsString(xDisplay, DefaultScreen(xDisplay)) : "";
+    XSetWindowAttributes windowAttributes;
+    windowAttributes.colormap = colormap;
+    windowAttributes.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask | StructureNotifyMask;
+
+    /* the event loop sleeps on the X connection instead of spinning */
+    int epollFd = create_epoll(ConnectionNumber(xDisplay));
+    if (epollFd < 0) {
+        if (egl.display != EGL_NO_DISPLAY)
+        {
+            eglTerminate(egl.display);
+        }
+
+        XCloseDisplay(xDisplay);
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    UnixApp *app = calloc(1, sizeof(UnixApp));
+    app->title = title;
+    app->appType = UNIX_APP_XORG;
+    app->config = config;
+    app->epollFd = epollFd;
+    app->data.xorgData.display = xDisplay;
+    app->data.xorgData.screen = DefaultScreen(xDisplay);
+    app->data.xorgData.root = RootWindow(xDisplay, app->data.xorgData.screen);
+    app->data.xorgData.bestFbc = bestFbc;
+    app->data.xorgData.visualInfo = vi;
+    app->data.xorgData.colormap = colormap;
+    app->data.xorgData.windowAttributes = windowAttributes;
+    app->egl = egl;
+
+    if (has_extension(glxExtensions, "GLX_EXT_swap_control"))
+    {
+        app->data.xorgData.glXSwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+        app->data.xorgData.hasSwapControlTear = has_extension(glxExtensions, "GLX_EXT_swap_control_tear");
+    }
+
+    if (has_extension(glxExtensions, "GLX_MESA_swap_control"))
+    {
+        app->data.xorgData.glXSwapIntervalMESA = (PFNGLXSWAPINTERVALMESAPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+    }
+
+    app->data.xorgData.hasBufferAge = has_extension(glxExtensions, "GLX_EXT_buffer_age");
+
+    if (has_extension(glxExtensions, "GLX_OML_sync_control"))
+    {
+        app->data.xorgData.glXGetSyncValuesOML = (PFNGLXGETSYNCVALUESOMLPROC)glXGetProcAddressARB((const GLubyte*)"glXGetSyncValuesOML");
+        app->data.xorgData.glXGetMscRateOML = (PFNGLXGETMSCRATEOMLPROC)glXGetProcAddressARB((const GLubyte*)"glXGetMscRateOML");
+        app->data.xorgData.glXWaitForSbcOML = (PFNGLXWAITFORSBCOMLPROC)glXGetProcAddressARB((const GLubyte*)"glXWaitForSbcOML");
+    }
+
+    if (config.softwareRendering)
+    {
+        /* shared memory only works when the server runs on this machine, remote displays get plain XPutImage */
+        app->data.xorgData.hasShm = XShmQueryExtension(xDisplay);
+        app->data.xorgData.shmCompletionEvent = XShmGetEventBase(xDisplay) + ShmCompletion;
+
+        log_info(app->data.xorgData.hasShm ? "Presenting software frames through MIT-SHM" : "MIT-SHM is unavailable, presenting software frames with XPutImage");
+    }
+
+    if (!open_task_queue(app))
+    {
+        if (egl.display != EGL_NO_DISPLAY)
+        {
+            eglTerminate(egl.display);
+        }
+
+        close(epollFd);
+        XCloseDisplay(xDisplay);
+        free(app);
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
+}
+
+static AppHandle_opt create_wayland_app(const char* title, AppConfig config)
+{
+    struct wl_display* display = wl_display_connect(NULL);
+    if (display == NULL)
+    {
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    log_info("Wayland environment detected");
+
+    UnixApp *app = calloc(1, sizeof(UnixApp));
+    app->title = title;
+    app->appType = UNIX_APP_WAYLAND;
+    app->config = config;
+    app->epollFd = -1;
+    app->data.waylandData.display = display;
+    app->egl.display = EGL_NO_DISPLAY;
+    app->egl.sharedContext = EGL_NO_CONTEXT;
+
+    /* collect the globals we need */
+    app->data.waylandData.registry = wl_display_get_registry(display);
+    wl_registry_add_listener(app->data.waylandData.registry, &registry_listener, app);
+    wl_display_roundtrip(display);
+
+    if (app->data.waylandData.compositor == NULL || app->data.waylandData.wmBase == NULL)
+    {
+        log_error("Compositor does not support xdg-shell");
+        destroy_wayland_app(app);
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    /* initialise egl on the wayland display */
+    if (!config.softwareRendering)
+    {
+        EGLDisplay eglDisplay = eglGetPlatformDisplay(EGL_PLATFORM_WAYLAND_KHR, display, NULL);
+        if (eglDisplay == EGL_NO_DISPLAY || !init_egl(&app->egl, eglDisplay, egl_config_attribs, config.surfaceFormat))
+        {
+            if (app->data.waylandData.shm == NULL)
+            {
+                destroy_wayland_app(app);
+                return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+            }
+
+            /* common in vms, where the compositor itself may be running on llvmpipe */
+            log_warn("Failed to initialise Wayland EGL, rendering on the cpu");
+            app->egl.display = EGL_NO_DISPLAY;
+        }
+    }
+
+    if (app->egl.display == EGL_NO_DISPLAY)
+    {
+        if (app->data.waylandData.shm == NULL)
+        {
+            log_error("Compositor does not support wl_shm");
+            destroy_wayland_app(app);
+            return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+
+        log_info("Presenting software frames through wl_shm");
+    }
+
+    app->epollFd = create_epoll(wl_display_get_fd(display));
+    if (app->epollFd < 0 || !open_task_queue(app))
+    {
+        destroy_wayland_app(app);
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
+}
+
+static void destroy_wayland_app(UnixApp* app)
+{
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        eglTerminate(app->egl.display);
+    }
+
+    release_wayland_pointer(app);
+    release_wayland_keyboard(app);
+
+    if (app->data.waylandData.seat != NULL)
+    {
+        wl_seat_destroy(app->data.waylandData.seat);
+    }
+
+    if (app->data.waylandData.shm != NULL)
+    {
+        wl_shm_destroy(app->data.waylandData.shm);
+    }
+
+    if (app->data.waylandData.decorationManager != NULL)
+    {
+        zxdg_decoration_manager_v1_destroy(app->data.waylandData.decorationManager);
+    }
+
+    if (app->data.waylandData.wmBase != NULL)
+    {
+        xdg_wm_base_destroy(app->data.waylandData.wmBase);
+    }
+
+    if (app->data.waylandData.compositor != NULL)
+    {
+        wl_compositor_destroy(app->data.waylandData.compositor);
+    }
+
+    if (app->data.waylandData.registry != NULL)
+    {
+        wl_registry_destroy(app->data.waylandData.registry);
+    }
+
+    if (app->epollFd >= 0)
+    {
+        close(app->epollFd);
+    }
+
+    wl_display_disconnect(app->data.waylandData.display);
+    free(app);
+}
+
+static AppHandle_opt create_headless_app(const char* title, AppConfig config)
+{
+    UnixApp *app = calloc(1, sizeof(UnixApp));
+    app->title = title;
+    app->appType = UNIX_APP_HEADLESS;
+    app->config = config;
+    app->egl.display = EGL_NO_DISPLAY;
+    app->egl.sharedContext = EGL_NO_CONTEXT;
+
+    /* there is no display connection to watch, but other sources still use the set */
+    app->epollFd = create_epoll(-1);
+    if (app->epollFd < 0 || !open_task_queue(app))
+    {
+        if (app->epollFd >= 0)
+        {
+            close(app->epollFd);
+        }
+
+        free(app);
+        return (AppHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    if (!config.softwareRendering)
+    {
+        /* mesa's surfaceless platform needs neither a display server nor a gpu (llvmpipe) */
+        EGLDisplay eglDisplay = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (eglDisplay == EGL_NO_DISPLAY)
+        {
+            eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        if (eglDisplay == EGL_NO_DISPLAY || !init_egl(&app->egl, eglDisplay, egl_pbuffer_config_attribs, config.surfaceFormat))
+        {
+            log_warn("Failed to initialise headless EGL, rendering on the cpu");
+        }
+    }
+
+    if (app->egl.display == EGL_NO_DISPLAY)
+    {
+        log_info("Headless environment created with cpu framebuffers");
+    }
+
+    return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
+}
+
+static bool has_extension(const char* extensions, const char* name)
+{
+    size_t length = strlen(name);
+
+    /* match whole names only, GLX_EXT_swap_control is a prefix of GLX_EXT_swap_control_tear */
+    for (const char* match = extensions; match != NULL && (match = strstr(match, name)) != NULL; match += length)
+    {
+        bool isStart = match == extensions || match[-1] == ' ';
+        bool isEnd = match[length] == ' ' || match[length] == '\0';
+
+        if (isStart && isEnd)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool init_egl(UnixEglData* egl, EGLDisplay display, const EGLint* configAttribs, SurfaceFormat format)
+{
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+    {
+        log_error("Failed to initialise EGL (0x%x)", eglGetError());
+        return false;
+    }
+
+    egl->display = display;
+    egl->sharedContext = EGL_NO_CONTEXT;
+    load_egl_extensions(egl);
+
+    /* srgb is picked per surface in egl, so without the extension it can't be had at all */
+    if (format.isSrgb && !egl->hasGlColorspace)
+    {
+        log_warn("EGL can't create sRGB surfaces, rendering in linear color");
+        format.isSrgb = false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API) || !choose_egl_config(egl, configAttribs, format))
+    {
+        log_error("Failed to retrieve an EGL config");
+        eglTerminate(display);
+        egl->display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    log_info("Initialised EGL %d.%d", major, minor);
+
+    return true;
+}
+
+static void load_egl_extensions(UnixEglData* egl)
+{
+    const char* eglExtensions = eglQueryString(egl->display, EGL_EXTENSIONS);
+
+    if (has_extension(eglExtensions, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        egl->eglSwapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    }
+    else if (has_extension(eglExtensions, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        /* same signature under the older name */
+        egl->eglSwapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+
+    if (has_extension(eglExtensions, "EGL_KHR_partial_update"))
+    {
+        egl->eglSetDamageRegion = (PFNEGLSETDAMAGEREGIONKHRPROC)eglGetProcAddress("eglSetDamageRegionKHR");
+    }
+
+    egl->hasBufferAge = has_extension(eglExtensions, "EGL_EXT_buffer_age") || egl->eglSetDamageRegion != NULL;
+    egl->hasGlColorspace = has_extension(eglExtensions, "EGL_KHR_gl_colorspace");
+}
+
+static bool choose_egl_config(UnixEglData* egl, const EGLint* configAttribs, SurfaceFormat format)
+{
+    EGLint configCount = 0;
+    if (!eglChooseConfig(egl->display, configAttribs, NULL, 0, &configCount) || configCount == 0)
+    {
+        return false;
+    }
+
+    EGLConfig* configs = malloc((size_t)configCount * sizeof(EGLConfig));
+    if (configs == NULL || !eglChooseConfig(egl->display, configAttribs, configs, configCount, &configCount))
+    {
+        free(configs);
+        return false;
+    }
+
+    int bestScore = -1;
+
+    for (EGLint i = 0; i < configCount; i++)
+    {
+        EGLint red, green, blue, alpha, depth, stencil, samples, caveat;
+        eglGetConfigAttrib(egl->display, configs[i], EGL_RED_SIZE, &red);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_GREEN_SIZE, &green);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_BLUE_SIZE, &blue);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_ALPHA_SIZE, &alpha);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_DEPTH_SIZE, &depth);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_STENCIL_SIZE, &stencil);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_SAMPLES, &samples);
+        eglGetConfigAttrib(egl->display, configs[i], EGL_CONFIG_CAVEAT, &caveat);
+
+        int score = score_config(format, (ConfigTraits) {
+            .colorBits = red + green + blue,
+            .alphaBits = alpha,
+            .depthBits = depth,
+            .stencilBits = stencil,
+            .samples = samples,
+            .isSrgbCapable = egl->hasGlColorspace,
+            .isSlow = caveat == EGL_SLOW_CONFIG
+        });
+
+        if (score >= 0 && (bestScore < 0 || score < bestScore))
+        {
+            bestScore = score;
+            egl->config = configs[i];
+        }
+    }
+
+    free(configs);
+    return bestScore >= 0;
+}
+
+static GLXFBConfig choose_glx_config(Display* display, SurfaceFormat format)
+{
+    int configCount = 0;
+    GLXFBConfig* configs = glXChooseFBConfig(display, DefaultScreen(display), visual_attribs, &configCount);
+    if (configs == NULL)
+    {
+        return NULL;
+    }
+
+    GLXFBConfig bestConfig = NULL;
+    int bestScore = -1;
+
+    for (int i = 0; i < configCount; i++)
+    {
+        int red, green, blue, alpha, depth, stencil, samples, caveat;
+        int srgb = False;
+        glXGetFBConfigAttrib(display, configs[i], GLX_RED_SIZE, &red);
+        glXGetFBConfigAttrib(display, configs[i], GLX_GREEN_SIZE, &green);
+        glXGetFBConfigAttrib(display, configs[i], GLX_BLUE_SIZE, &blue);
+        glXGetFBConfigAttrib(display, configs[i], GLX_ALPHA_SIZE, &alpha);
+        glXGetFBConfigAttrib(display, configs[i], GLX_DEPTH_SIZE, &depth);
+        glXGetFBConfigAttrib(display, configs[i], GLX_STENCIL_SIZE, &stencil);
+        glXGetFBConfigAttrib(display, configs[i], GLX_SAMPLES, &samples);
+        glXGetFBConfigAttrib(display, configs[i], GLX_CONFIG_CAVEAT, &caveat);
+
+        /* left at False by servers without GLX_ARB_framebuffer_sRGB */
+        glXGetFBConfigAttrib(display, configs[i], GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB, &srgb);
+
+        int score = score_config(format, (ConfigTraits) {
+            .colorBits = red + green + blue,
+            .alphaBits = alpha,
+            .depthBits = depth,
+            .stencilBits = stencil,
+            .samples = samples,
+            .isSrgbCapable = srgb == True,
+            .isSlow = caveat == GLX_SLOW_CONFIG
+        });
+
+        if (score >= 0 && (bestScore < 0 || score < bestScore))
+        {
+            bestScore = score;
+            bestConfig = configs[i];
+        }
+    }
+
+    XFree(configs);
+
+    if (bestConfig == NULL && format.isSrgb)
+    {
+        log_warn("No sRGB capable framebuffer config, rendering in linear color");
+        format.isSrgb = false;
+        return choose_glx_config(display, format);
+    }
+
+    return bestConfig;
+}
+
+static int score_config(SurfaceFormat format, ConfigTraits traits)
+{
+    int samples = traits.samples > 1 ? traits.samples : 1;
+    int requiredSamples = format.samples > 1 ? format.samples : 1;
+
+    if (traits.colorBits < 24 ||
+        traits.depthBits < format.depthBits ||
+        traits.stencilBits < format.stencilBits ||
+        samples < requiredSamples ||
+        (format.hasAlpha && traits.alphaBits == 0) ||
+        (format.isSrgb && !traits.isSrgbCapable))
+    {
+        return -1;
+    }
+
+    /* bits stored per pixel approximates the bandwidth every clear and resolve costs */
+    int score = (traits.colorBits + traits.alphaBits + traits.depthBits + traits.stencilBits) * samples;
+
+    /* caveated configs are typically unaccelerated, anything else wins */
+    if (traits.isSlow)
+    {
+        score += 1 << 16;
+    }
+
+    return score;
+}
+
+static XVisualInfo* choose_xorg_egl_visual(Display* display, UnixEglData* egl, SurfaceFormat format)
+{
+    EGLDisplay eglDisplay = eglGetPlatformDisplay(EGL_PLATFORM_X11_KHR, display, NULL);
+    if (eglDisplay == EGL_NO_DISPLAY || !init_egl(egl, eglDisplay, egl_config_attribs, format))
+    {
+        return NULL;
+    }
+
+    /* the window has to be created with the visual the config renders in */
+    EGLint visualId = 0;
+    eglGetConfigAttrib(eglDisplay, egl->config, EGL_NATIVE_VISUAL_ID, &visualId);
+
+    XVisualInfo visualTemplate = { .visualid = (VisualID)visualId };
+    int visualCount = 0;
+    XVisualInfo* vi = XGetVisualInfo(display, VisualIDMask, &visualTemplate, &visualCount);
+
+    if (vi == NULL)
+    {
+        log_error("Failed to get a visual for the EGL config");
+        eglTerminate(eglDisplay);
+        egl->display = EGL_NO_DISPLAY;
+    }
+
+    return vi;
+}
+
+static XVisualInfo* choose_xorg_image_visual(Display* display)
+{
+    Visual* visual = DefaultVisual(display, DefaultScreen(display));
+
+    XVisualInfo visualTemplate = { .visualid = XVisualIDFromVisual(visual) };
+    int visualCount = 0;
+    XVisualInfo* vi = XGetVisualInfo(display, VisualIDMask, &visualTemplate, &visualCount);
+
+    /* pixels are written straight from the channel masks, which palette visuals don't have */
+    if (vi == NULL || vi->class != TrueColor)
+    {
+        log_error("Software rendering needs a true color visual");
+
+        if (vi != NULL)
+        {
+            XFree(vi);
+        }
+
+        return NULL;
+    }
+
+    return vi;
+}
+
+static int create_epoll(int displayFd)
+{
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        log_error("Failed to create epoll instance");
+        return -1;
+    }
+
+    if (displayFd < 0)
+    {
+        return epollFd;
+    }
+
+    struct epoll_event displayEvent = { .events = EPOLLIN, .data.u32 = UNIX_APP_SOURCE_DISPLAY };
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, displayFd, &displayEvent) < 0) {
+        log_error("Failed to watch the display connection");
+        close(epollFd);
+        return -1;
+    }
+
+    return epollFd;
+}
+
+static int wait_for_events(UnixApp* app, int timeout)
+{
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+
+    int count = epoll_wait(app->epollFd, events, MAX_EPOLL_EVENTS, timeout);
+    if (count < 0)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+
+        log_error("Failed to wait for events");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data.u32 == UNIX_APP_SOURCE_RENDER_THREAD)
+        {
+            collect_retired_windows(app);
+        }
+        else if (events[i].data.u32 == UNIX_APP_SOURCE_TIMER)
+        {
+            run_due_timers(app);
+        }
+        else if (events[i].data.u32 == UNIX_APP_SOURCE_TASKS)
+        {
+            run_posted_tasks(app);
+        }
+    }
+
+    return count;
+}
+
+static int dispatch_app(UnixApp* app, int timeout)
+{
+    /* apps driven by poll_events and friends never go through run_app */
+    start_configured_render_thread(app);
+
+    /* coalescing never reaches back past events the caller may already have taken */
+    app->eventQueue.passStart = app->eventQueue.pushCount;
+
+    /* a busy display never lets the loop sleep, so timers and tasks are checked on every pass */
+    run_due_timers(app);
+    run_posted_tasks(app);
+
+    if (app->appType == UNIX_APP_XORG)
+    {
+        Display* display = app->data.xorgData.display;
+
+        process_xorg_events(app);
+
+        if (app->renderThread != NULL)
+        {
+            flush_render_messages(app);
+        }
+        else
+        {
+            render_windows(app);
+        }
+
+        /* only sleep when nothing arrived while rendering and nothing is waiting to be read */
+        if (timeout != 0 && app->registry.count > 0 && app->eventQueue.count == 0 && !XPending(display))
+        {
+            if (wait_for_events(app, timeout) < 0)
+            {
+                return -1;
+            }
+
+            process_xorg_events(app);
+        }
+    }
+    else if (app->appType == UNIX_APP_WAYLAND)
+    {
+        struct wl_display* display = app->data.waylandData.display;
+
+        if (wl_display_dispatch_pending(display) < 0)
+        {
+            log_error("Lost the Wayland connection");
+            return -1;
+        }
+
+        /* egl reads from the display inside eglSwapBuffers, so render before preparing our own read */
+        render_windows(app);
+
+        if (app->registry.count == 0)
+        {
+            return 0;
+        }
+
+        if (wl_display_prepare_read(display) != 0)
+        {
+            /* events were queued while rendering, they are handled on the next pass */
+            return 0;
+        }
+
+        wl_display_flush(display);
+
+        if (wait_for_events(app, app->eventQueue.count > 0 ? 0 : timeout) > 0)
+        {
+            if (wl_display_read_events(display) < 0)
+            {
+                log_error("Lost the Wayland connection");
+                return -1;
+            }
+        }
+        else
+        {
+            wl_display_cancel_read(display);
+        }
+
+        if (wl_display_dispatch_pending(display) < 0)
+        {
+            log_error("Lost the Wayland connection");
+            return -1;
+        }
+    }
+    else if (app->appType == UNIX_APP_HEADLESS)
+    {
+        if (app->renderThread != NULL)
+        {
+            flush_render_messages(app);
+        }
+        else
+        {
+            render_windows(app);
+        }
+
+        /* only timers and posted tasks can wake a headless app */
+        if (timeout != 0 && app->eventQueue.count == 0)
+        {
+            if (wait_for_events(app, timeout) < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void handle_registry_global(void* data, struct wl_registry* registry, uint32_t name, const char* interface, uint32_t version)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0)
+    {
+        app->data.waylandData.compositor = wl_registry_bind(registry, name, &wl_compositor_interface, version < 4 ? version : 4);
+    }
+    else if (strcmp(interface, xdg_wm_base_interface.name) == 0)
+    {
+        /* our generated xdg-shell header only knows the version 1 events */
+        app->data.waylandData.wmBase = wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(app->data.waylandData.wmBase, &wm_base_listener, app);
+    }
+    else if (strcmp(interface, zxdg_decoration_manager_v1_interface.name) == 0)
+    {
+        app->data.waylandData.decorationManager = wl_registry_bind(registry, name, &zxdg_decoration_manager_v1_interface, 1);
+    }
+    else if (strcmp(interface, wl_shm_interface.name) == 0)
+    {
+        app->data.waylandData.shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    }
+    else if (strcmp(interface, wl_seat_interface.name) == 0 && app->data.waylandData.seat == NULL)
+    {
+        /* version 5 is as far as our pointer listener goes, further seats are ignored */
+        app->data.waylandData.seat = wl_registry_bind(registry, name, &wl_seat_interface, version < 5 ? version : 5);
+        wl_seat_add_listener(app->data.waylandData.seat, &seat_listener, app);
+    }
+}
+
+static void handle_registry_global_remove(void* data, struct wl_registry* registry, uint32_t name)
+{
+}
+
+static void handle_wm_base_ping(void* data, struct xdg_wm_base* wmBase, uint32_t serial)
+{
+    xdg_wm_base_pong(wmBase, serial);
+}
+
+static void handle_seat_capabilities(void* data, struct wl_seat* seat, uint32_t capabilities)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    bool hasPointer = (capabilities & WL_SEAT_CAPABILITY_POINTER) != 0;
+    if (hasPointer && app->data.waylandData.pointer == NULL)
+    {
+        app->data.waylandData.pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(app->data.waylandData.pointer, &pointer_listener, app);
+    }
+    else if (!hasPointer)
+    {
+        release_wayland_pointer(app);
+    }
+
+    bool hasKeyboard = (capabilities & WL_SEAT_CAPABILITY_KEYBOARD) != 0;
+    if (hasKeyboard && app->data.waylandData.keyboard == NULL)
+    {
+        app->data.waylandData.keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(app->data.waylandData.keyboard, &keyboard_listener, app);
+    }
+    else if (!hasKeyboard)
+    {
+        release_wayland_keyboard(app);
+    }
+}
+
+static void handle_seat_name(void* data, struct wl_seat* seat, const char* name)
+{
+}
+
+static void handle_pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial, struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    app->data.waylandData.pointerSurface = surface;
+    app->data.waylandData.pointerX = wl_fixed_to_int(x);
+    app->data.waylandData.pointerY = wl_fixed_to_int(y);
+}
+
+static void handle_pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial, struct wl_surface* surface)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    app->data.waylandData.pointerSurface = NULL;
+}
+
+static void handle_pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    app->data.waylandData.pointerX = wl_fixed_to_int(x);
+    app->data.waylandData.pointerY = wl_fixed_to_int(y);
+
+    /* the surface may already be gone, its window unregistered with it */
+    UnixWindow* window = find_window(app, (uintptr_t)app->data.waylandData.pointerSurface);
+    if (window == NULL)
+    {
+        return;
+    }
+
+    AngeloEvent event = { .type = ANGELO_EVENT_POINTER_MOTION, .time = time, .window = (WindowHandle)window };
+    event.data.motion.x = app->data.waylandData.pointerX;
+    event.data.motion.y = app->data.waylandData.pointerY;
+
+    push_app_event(app, event);
+}
+
+static void handle_pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    UnixWindow* window = find_window(app, (uintptr_t)app->data.waylandData.pointerSurface);
+    if (window == NULL)
+    {
+        return;
+    }
+
+    AngeloEvent event = { .type = ANGELO_EVENT_POINTER_BUTTON, .time = time, .window = (WindowHandle)window };
+    event.data.button.x = app->data.waylandData.pointerX;
+    event.data.button.y = app->data.waylandData.pointerY;
+    event.data.button.button = translate_wayland_button(button);
+    event.data.button.isPressed = state == WL_POINTER_BUTTON_STATE_PRESSED;
+
+    push_app_event(app, event);
+}
+
+static void handle_pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time, uint32_t axis, wl_fixed_t value)
+{
+    /* scrolling has no event of its own yet */
+}
+
+static void handle_pointer_frame(void* data, struct wl_pointer* pointer)
+{
+    /* events are queued as they arrive, motion coalescing already merges what a frame would */
+}
+
+static void handle_pointer_axis_source(void* data, struct wl_pointer* pointer, uint32_t source)
+{
+}
+
+static void handle_pointer_axis_stop(void* data, struct wl_pointer* pointer, uint32_t time, uint32_t axis)
+{
+}
+
+static void handle_pointer_axis_discrete(void* data, struct wl_pointer* pointer, uint32_t axis, int32_t discrete)
+{
+}
+
+static void handle_keyboard_keymap(void* data, struct wl_keyboard* keyboard, uint32_t format, int32_t fd, uint32_t size)
+{
+    /* keys are reported as keycodes, so the keymap is never read */
+    close(fd);
+}
+
+static void handle_keyboard_enter(void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface, struct wl_array* keys)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    app->data.waylandData.keyboardSurface = surface;
+}
+
+static void handle_keyboard_leave(void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    app->data.waylandData.keyboardSurface = NULL;
+}
+
+static void handle_keyboard_key(void* data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state)
+{
+    UnixApp* app = (UnixApp*)data;
+
+    UnixWindow* window = find_window(app, (uintptr_t)app->data.waylandData.keyboardSurface);
+    if (window == NULL)
+    {
+        return;
+    }
+
+    AngeloEvent event = { .type = ANGELO_EVENT_KEY, .time = time, .window = (WindowHandle)window };
+
+    /* evdev codes are offset by 8 in xkb, which is what Xorg reports */
+    event.data.key.keycode = key + 8;
+    event.data.key.isPressed = state == WL_KEYBOARD_KEY_STATE_PRESSED;
+
+    push_app_event(app, event);
+}
+
+static void handle_keyboard_modifiers(void* data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group)
+{
+}
+
+static void handle_keyboard_repeat_info(void* data, struct wl_keyboard* keyboard, int32_t rate, int32_t delay)
+{
+}
+
+static void process_xorg_events(UnixApp* app)
+{
+    Display* display = app->data.xorgData.display;
+
+    bool hasPendingResize = false;
+
+    /* once the queue is full the rest stay with Xlib until the next pass */
+    while (app->eventQueue.count < UNIX_APP_EVENT_CAPACITY && XPending(display))
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        process_xorg_event(app, &event);
+
+        hasPendingResize |= event.type == ConfigureNotify;
+    }
+
+    /* a live resize sends dozens of configures, the surface only follows the last of them */
+    for (size_t i = 0; hasPendingResize && i < app->registry.count; i++)
+    {
+        UnixWindow* window = app->registry.windows[i];
+
+        if (window->hasPendingResize)
+        {
+            window->hasPendingResize = false;
+            resize_unix_window(app, window, window->configuredWidth, window->configuredHeight);
+        }
+    }
+}
+
+static void process_xorg_event(UnixApp* app, XEvent* event)
+{
+    UnixWindow* window = find_window(app, (uintptr_t)event->xany.window);
+
+    if (window == NULL)
+    {
+        return;
+    }
+
+    AngeloEvent angeloEvent = { .type = ANGELO_EVENT_NONE, .window = (WindowHandle)window };
+
+    switch (event->type)
+    {
+        case Expose:
+        {
+            WindowRect rect = { event->xexpose.x, event->xexpose.y, event->xexpose.width, event->xexpose.height };
+
+            /* invalidations are unioned, so a series of exposes still costs one frame */
+            invalidate_rect((AppHandle)app, (WindowHandle)window, rect);
+
+            angeloEvent.type = ANGELO_EVENT_WINDOW_EXPOSE;
+            angeloEvent.data.expose = rect;
+            break;
+        }
+        case ConfigureNotify:
+        {
+            /* moves arrive as configures too, only report size changes */
+            if (event->xconfigure.width != window->configuredWidth || event->xconfigure.height != window->configuredHeight)
+            {
+                window->configuredWidth = event->xconfigure.width;
+                window->configuredHeight = event->xconfigure.height;
+                window->hasPendingResize = true;
+
+                angeloEvent.type = ANGELO_EVENT_WINDOW_RESIZE;
+                angeloEvent.data.resize.width = event->xconfigure.width;
+                angeloEvent.data.resize.height = event->xconfigure.height;
+            }
+            break;
+        }
+        case MotionNotify:
+        {
+            angeloEvent.type = ANGELO_EVENT_POINTER_MOTION;
+            angeloEvent.time = (uint32_t)event->xmotion.time;
+            angeloEvent.data.motion.x = event->xmotion.x;
+            angeloEvent.data.motion.y = event->xmotion.y;
+            break;
+        }
+        case ButtonPress:
+        case ButtonRelease:
+        {
+            angeloEvent.type = ANGELO_EVENT_POINTER_BUTTON;
+            angeloEvent.time = (uint32_t)event->xbutton.time;
+            angeloEvent.data.button.x = event->xbutton.x;
+            angeloEvent.data.button.y = event->xbutton.y;
+            angeloEvent.data.button.button = event->xbutton.button;
+            angeloEvent.data.button.isPressed = event->type == ButtonPress;
+            break;
+        }
+        case KeyPress:
+        case KeyRelease:
+        {
+            angeloEvent.type = ANGELO_EVENT_KEY;
+            angeloEvent.time = (uint32_t)event->xkey.time;
+            angeloEvent.data.key.keycode = event->xkey.keycode;
+            angeloEvent.data.key.isPressed = event->type == KeyPress;
+            break;
+        }
+        case ClientMessage:
+        {
+            if ((Atom)event->xclient.data.l[0] == window->data.xorgData.deleteMessage)
+            {
+                log_info("Window closed");
+                push_app_event(app, (AngeloEvent) { .type = ANGELO_EVENT_WINDOW_CLOSE, .window = (WindowHandle)window });
+                destroy_unix_window(app, window);
+            }
+            break;
+        }
+        default:
+        {
+            /* the completion's drawable lines up with xany.window, so the lookup above already found it */
+            if (app->data.xorgData.hasShm && event->type == app->data.xorgData.shmCompletionEvent)
+            {
+                release_xorg_image(app, window, ((XShmCompletionEvent*)event)->shmseg);
+            }
+            break;
+        }
+    }
+
+    if (angeloEvent.type != ANGELO_EVENT_NONE)
+    {
+        push_app_event(app, angeloEvent);
+    }
+}
+
+static void release_wayland_pointer(UnixApp* app)
+{
+    struct wl_pointer* pointer = app->data.waylandData.pointer;
+
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    /* release tells the compositor too, older seats only have the local destroy */
+    if (wl_pointer_get_version(pointer) >= WL_POINTER_RELEASE_SINCE_VERSION)
+    {
+        wl_pointer_release(pointer);
+    }
+    else
+    {
+        wl_pointer_destroy(pointer);
+    }
+
+    app->data.waylandData.pointer = NULL;
+    app->data.waylandData.pointerSurface = NULL;
+}
+
+static void release_wayland_keyboard(UnixApp* app)
+{
+    struct wl_keyboard* keyboard = app->data.waylandData.keyboard;
+
+    if (keyboard == NULL)
+    {
+        return;
+    }
+
+    if (wl_keyboard_get_version(keyboard) >= WL_KEYBOARD_RELEASE_SINCE_VERSION)
+    {
+        wl_keyboard_release(keyboard);
+    }
+    else
+    {
+        wl_keyboard_destroy(keyboard);
+    }
+
+    app->data.waylandData.keyboard = NULL;
+    app->data.waylandData.keyboardSurface = NULL;
+}
+
+static uint32_t translate_wayland_button(uint32_t button)
+{
+    /* Xorg numbering, so both backends report the same buttons */
+    switch (button)
+    {
+        case BTN_LEFT:
+        {
+            return 1;
+        }
+        case BTN_MIDDLE:
+        {
+            return 2;
+        }
+        case BTN_RIGHT:
+        {
+            return 3;
+        }
+        case BTN_SIDE:
+        {
+            return 8;
+        }
+        case BTN_EXTRA:
+        {
+            return 9;
+        }
+        default:
+        {
+            return button;
+        }
+    }
+}
+
+static void start_configured_render_thread(UnixApp* app)
+{
+    if (!app->config.renderThread || app->hasTriedRenderThread)
+    {
+        return;
+    }
+
+    app->hasTriedRenderThread = true;
+
+    /* egl and frame callbacks both need the display queue, so wayland renders on the event thread */
+    if (app->appType == UNIX_APP_WAYLAND)
+    {
+        log_warn("The render thread is not supported on Wayland, rendering on the event thread");
+        return;
+    }
+
+    start_render_thread(app);
+}
+
+static void render_windows(UnixApp* app)
+{
+    for (size_t i = 0; i < app->registry.count; i++)
+    {
+        render_unix_window(app, app->registry.windows[i]);
+    }
+}
+
+static size_t hash_window_key(uintptr_t key, size_t slotCapacity)
+{
+    /* fibonacci hashing spreads the sequential ids X hands out */
+    return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> 32) & (slotCapacity - 1);
+}
+
+static bool grow_window_slots(UnixApp* app)
+{
+    UnixWindowRegistry* registry = &app->registry;
+
+    size_t slotCapacity = registry->slotCapacity == 0 ? 16 : registry->slotCapacity * 2;
+    UnixWindowSlot* slots = calloc(slotCapacity, sizeof(UnixWindowSlot));
+    if (slots == NULL)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        UnixWindow* window = registry->windows[i];
+        size_t index = hash_window_key(window->registryKey, slotCapacity);
+
+        while (slots[index].key != 0)
+        {
+            index = (index + 1) & (slotCapacity - 1);
+        }
+
+        slots[index] = (UnixWindowSlot) { .key = window->registryKey, .window = window };
+    }
+
+    free(registry->slots);
+    registry->slots = slots;
+    registry->slotCapacity = slotCapacity;
+
+    return true;
+}
@@ -20,21 +20,36 @@
 ***************************************************************/
 
 #include <stdint.h>
+#include <stddef.h>
 #include "../util/util.h"
 #include "../win/win.h"
+#include "../event/event.h"
+#include "../util/mpsc_queue.h"
 
 #ifdef __unix
 
     #include <X11/Xlib.h>
+    #include <X11/extensions/XShm.h>
     #include <GL/gl.h>
     #include <GL/glx.h>
 
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+    #include <wayland-client.h>
+    #include <wayland-egl.h>
+
+    #include "../misc/wayland/xdg-shell-client-header.h"
+    #include "../misc/wayland/xdg-decoration.h"
+
 #endif 
 
 /***************************************************************
 ** MARK: CONSTANTS & MACROS
 ***************************************************************/
 
+/* events queued between two poll_events calls, a power of two */
+#define UNIX_APP_EVENT_CAPACITY 1024
+
 /***************************************************************
 ** MARK: TYPEDEFS
 ***************************************************************/
@@ -44,13 +59,106 @@
     typedef enum
     {
         UNIX_APP_UNDEFINED,
-        UNIX_APP_XORG
+        UNIX_APP_XORG,
+        UNIX_APP_WAYLAND,
+        UNIX_APP_HEADLESS
     } UnixAppType;
 
+    struct UnixWindow;
+    struct UnixRenderThread;
+    struct UnixTimer;
+
+    typedef struct
+    {
+        /* native window id, 0 marks an empty slot */
+        uintptr_t key;
+        struct UnixWindow* window;
+    } UnixWindowSlot;
+
+    typedef struct
+    {
+        /* dense list of live windows for iteration */
+        struct UnixWindow** windows;
+        size_t count;
+        size_t capacity;
+
+        /* open addressing table (linear probing) from native id to window */
+        UnixWindowSlot* slots;
+        size_t slotCapacity;
+    } UnixWindowRegistry;
+
+    typedef struct
+    {
+        /* timerfd armed for the earliest deadline, opened along with the heap */
+        int timerFd;
+
+        /* binary min-heap ordered by deadline */
+        struct UnixTimer** heap;
+        size_t count;
+        size_t capacity;
+    } UnixTimerQueue;
+
+    typedef struct
+    {
+        MpscQueue queue;
+
+        /* eventfd in the epoll set, written by the first post after each drain */
+        int eventFd;
+        atomic_bool isWakePending;
+    } UnixTaskQueue;
+
+    /* the EGL display, config and share group every backend renders through unless Xorg uses GLX */
+    typedef struct
+    {
+        /* EGL_NO_DISPLAY when rendering through GLX or into cpu framebuffers */
+        EGLDisplay display;
+        EGLConfig config;
+
+        /* root of the share group, or the only context in single context mode */
+        EGLContext sharedContext;
+
+        /* for redrawing and presenting only what changed, NULL when missing */
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC eglSwapBuffersWithDamage;
+        PFNEGLSETDAMAGEREGIONKHRPROC eglSetDamageRegion;
+        bool hasBufferAge;
+
+        /* EGL_KHR_gl_colorspace, for sRGB window surfaces */
+        bool hasGlColorspace;
+    } UnixEglData;
+
+    /* ring of events waiting for poll_events, stored inline so queueing never allocates */
+    typedef struct
+    {
+        AngeloEvent events[UNIX_APP_EVENT_CAPACITY];
+        size_t head;
+        size_t count;
+
+        /* sequence numbers of every event ever queued, and of the first one this dispatch pass */
+        uint64_t pushCount;
+        uint64_t passStart;
+    } UnixEventQueue;
+
+    /* tags stored in epoll_event.data.u32 to identify wakeup sources */
+    typedef enum
+    {
+        UNIX_APP_SOURCE_DISPLAY,
+        UNIX_APP_SOURCE_RENDER_THREAD,
+        UNIX_APP_SOURCE_TIMER,
+        UNIX_APP_SOURCE_TASKS
+    } UnixAppSource;
+
     typedef struct 
     {
         const char* title;
         UnixAppType appType;
+        AppConfig config;
+
+        /* what is bound on the render thread, so redundant make current calls can be skipped */
+        uintptr_t currentDrawable;
+        uintptr_t currentContext;
+
+        /* epoll set that run_app blocks on */
+        int epollFd;
 
         union 
         {
@@ -59,15 +167,72 @@
                 Display* display;
                 int screen;
                 Window root;
+                /* NULL when the app renders through EGL */
                 GLXFBConfig bestFbc;
                 XVisualInfo* visualInfo;
                 Colormap colormap;
                 XSetWindowAttributes windowAttributes;
+
+                /* root of the share group, or the only context in single context mode */
+                GLXContext sharedContext;
+
+                /* swap control extensions, in order of preference */
+                PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT;
+                PFNGLXSWAPINTERVALMESAPROC glXSwapIntervalMESA;
+                bool hasSwapControlTear;
+
+                /* GLX_OML_sync_control, for display timing */
+                PFNGLXGETSYNCVALUESOMLPROC glXGetSyncValuesOML;
+                PFNGLXGETMSCRATEOMLPROC glXGetMscRateOML;
+                PFNGLXWAITFORSBCOMLPROC glXWaitForSbcOML;
+
+                bool hasBufferAge;
+
+                /* MIT-SHM, for presenting software rendered windows without copying through the socket */
+                bool hasShm;
+                int shmCompletionEvent;
             } xorgData;
 
+            struct
+            {
+                struct wl_display* display;
+                struct wl_registry* registry;
+                struct wl_compositor* compositor;
+                struct xdg_wm_base* wmBase;
+                struct zxdg_decoration_manager_v1* decorationManager;
+
+                /* cpu framebuffers are shared with the compositor through this, used when there is no EGL display */
+                struct wl_shm* shm;
+
+                /* the first seat, its pointer and keyboard exist while it has those capabilities */
+                struct wl_seat* seat;
+                struct wl_pointer* pointer;
+                struct wl_keyboard* keyboard;
+
+                /* surfaces with pointer and keyboard focus, the input events themselves don't name one */
+                struct wl_surface* pointerSurface;
+                struct wl_surface* keyboardSurface;
+                int pointerX;
+                int pointerY;
+            } waylandData;
+
         } data;
 
-        WindowHandle windowHandle;
+        UnixEglData egl;
+
+        UnixWindowRegistry registry;
+
+        UnixEventQueue eventQueue;
+
+        UnixTimerQueue timerQueue;
+
+        UnixTaskQueue taskQueue;
+
+        /* only set while rendering is handed to its own thread */
+        struct UnixRenderThread* renderThread;
+
+        /* the render thread is only tried once, so a failure or an unsupported backend warns once */
+        bool hasTriedRenderThread;
 
     } UnixApp;
 
@@ -77,4 +242,23 @@
 ** MARK: FUNCTION DEFS
 ***************************************************************/
 
+#ifdef __unix
+
+    /* 
+    ** the key is the id native events refer to the window by: the X window,
+    ** the wl_surface pointer, or the window itself for headless apps.
+    */
+    bool register_window(UnixApp* app, uintptr_t key, struct UnixWindow* window);
+    void unregister_window(UnixApp* app, struct UnixWindow* window);
+    struct UnixWindow* find_window(UnixApp* app, uintptr_t key);
+
+    /* 
+    ** event thread only, the event is dropped if the queue is full. unless
+    ** keepEventHistory is set, motion and resize events replace the one their
+    ** window already queued in the same dispatch pass.
+    */
+    void push_app_event(UnixApp* app, AngeloEvent event);
+
+#endif
+
 #endif /* APP_UNIX_H */
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "app.h"
 
 #include "../debug/debug.h"
+#include "../event/event.h"
 
 #include <windows.h>
 
@@ -56,6 +57,12 @@ AppHandle_opt create_app(const char* title)
     return (AppHandle_opt) { .value = (intptr_t)app, .is_some = true };
 }
 
+AppHandle_opt create_app_with_config(const char* title, AppConfig config)
+{
+    /* there is only one backend on this platform */
+    return create_app(title);
+}
+
 int run_app(AppHandle handle)
 {   
     WindowsApp *app = (WindowsApp*)handle;
@@ -81,6 +88,61 @@ int run_app(AppHandle handle)
     return 0;
 }
 
+int get_app_fd(AppHandle handle)
+{
+    /* the message queue can't be waited on as an fd */
+    return -1;
+}
+
+int dispatch_app_pending(AppHandle handle)
+{
+    AngeloEvent events[1];
+    poll_events(handle, events, 0);
+
+    return 0;
+}
+
+int64_t get_app_next_deadline(AppHandle handle)
+{
+    return -1;
+}
+
+AppTimerHandle_opt add_app_timer(AppHandle handle, uint64_t intervalNanos, AppTimerCallback callback, void* userData)
+{
+    log_error("Timers are not supported on this platform yet");
+    return (AppTimerHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+}
+
+void remove_app_timer(AppHandle handle, AppTimerHandle timer)
+{
+}
+
+bool post_app_task(AppHandle handle, AppTaskCallback callback, void* userData)
+{
+    log_error("Task posting is not supported on this platform yet");
+    return false;
+}
+
+size_t poll_events(AppHandle handle, AngeloEvent* events, size_t capacity)
+{
+    /* messages are still dispatched to the window procedures, none are translated into events yet */
+    MSG msg;
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+    {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    return 0;
+}
+
+size_t wait_events(AppHandle handle, AngeloEvent* events, size_t capacity, int timeout)
+{
+    MsgWaitForMultipleObjects(0, NULL, FALSE, timeout < 0 ? INFINITE : (DWORD)timeout, QS_ALLINPUT);
+
+    return poll_events(handle, events, capacity);
+}
+
 /***************************************************************
 ** MARK: STATIC FUNCTIONS
 ***************************************************************/
@@ -0,0 +1,167 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  task_unix.c
+** Module       :  app
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-17 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix cross-thread task posting. Tasks go through
+**                 a lock-free MPSC queue and an eventfd in the app's
+**                 epoll set wakes the event thread, written at most
+**                 once per drain however many threads post.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "app.h"
+#include "app_unix.h"
+#include "task_unix.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/* tasks run per pass before events get a turn, the rest run on the next */
+#define MAX_TASKS_PER_PASS 1024
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static void wake_task_queue(UnixTaskQueue* queue);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+bool post_app_task(AppHandle handle, AppTaskCallback callback, void* userData)
+{
+    UnixApp* app = (UnixApp*)handle;
+
+    if (app == NULL || callback == NULL)
+    {
+        log_error("Invalid app handle or callback");
+        return false;
+    }
+
+    UnixTask* task = malloc(sizeof(UnixTask));
+    if (task == NULL)
+    {
+        log_error("Failed to allocate a task");
+        return false;
+    }
+
+    task->callback = callback;
+    task->userData = userData;
+
+    mpsc_queue_push(&app->taskQueue.queue, &task->node);
+
+    /* only the first post since the last drain pays for the syscall */
+    if (!atomic_exchange_explicit(&app->taskQueue.isWakePending, true, memory_order_seq_cst))
+    {
+        wake_task_queue(&app->taskQueue);
+    }
+
+    return true;
+}
+
+bool open_task_queue(UnixApp* app)
+{
+    UnixTaskQueue* queue = &app->taskQueue;
+
+    create_mpsc_queue(&queue->queue);
+    atomic_init(&queue->isWakePending, false);
+
+    queue->eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (queue->eventFd < 0)
+    {
+        log_error("Failed to create the task eventfd");
+        return false;
+    }
+
+    struct epoll_event taskEvent = { .events = EPOLLIN, .data.u32 = UNIX_APP_SOURCE_TASKS };
+    if (epoll_ctl(app->epollFd, EPOLL_CTL_ADD, queue->eventFd, &taskEvent) < 0)
+    {
+        log_error("Failed to watch the task eventfd");
+        close(queue->eventFd);
+        return false;
+    }
+
+    return true;
+}
+
+void run_posted_tasks(UnixApp* app)
+{
+    UnixTaskQueue* queue = &app->taskQueue;
+
+    if (!atomic_load_explicit(&queue->isWakePending, memory_order_acquire))
+    {
+        return;
+    }
+
+    uint64_t count;
+    while (read(queue->eventFd, &count, sizeof(count)) < 0 && errno == EINTR)
+    {
+    }
+
+    /* reopen the wakeup only after clearing the fd, so a post racing the drain signals again */
+    atomic_store_explicit(&queue->isWakePending, false, memory_order_seq_cst);
+
+    for (int i = 0; i < MAX_TASKS_PER_PASS; i++)
+    {
+        UnixTask* task = (UnixTask*)mpsc_queue_pop(&queue->queue);
+        if (task == NULL)
+        {
+            return;
+        }
+
+        task->callback((AppHandle)app, task->userData);
+        free(task);
+    }
+
+    /* tasks were left behind, make sure the next wait doesn't sleep on them */
+    if (!atomic_exchange_explicit(&queue->isWakePending, true, memory_order_acq_rel))
+    {
+        wake_task_queue(queue);
+    }
+}
+
+bool has_posted_tasks(UnixApp* app)
+{
+    /* set by the first post after each drain, and again when a drain leaves tasks behind */
+    return atomic_load_explicit(&app->taskQueue.isWakePending, memory_order_acquire);
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static void wake_task_queue(UnixTaskQueue* queue)
+{
+    uint64_t value = 1;
+    while (write(queue->eventFd, &value, sizeof(value)) < 0 && errno == EINTR)
+    {
+    }
+}
@@ -0,0 +1,66 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  task_unix.h
+** Module       :  app
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-17 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix cross-thread task posting
+**
+***************************************************************/
+
+#ifndef TASK_UNIX_H
+#define TASK_UNIX_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include "../util/util.h"
+#include "../util/mpsc_queue.h"
+#include "app.h"
+#include "app_unix.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+#ifdef __unix
+
+    typedef struct
+    {
+        /* first so a popped node is the task */
+        MpscNode node;
+
+        AppTaskCallback callback;
+        void* userData;
+    } UnixTask;
+
+#endif
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+#ifdef __unix
+
+    /* creates the queue and adds its eventfd to the app's epoll set */
+    bool open_task_queue(UnixApp* app);
+
+    /* event thread only, runs the tasks posted so far */
+    void run_posted_tasks(UnixApp* app);
+
+    /* true while posted tasks are waiting for run_posted_tasks */
+    bool has_posted_tasks(UnixApp* app);
+
+#endif
+
+#endif /* TASK_UNIX_H */
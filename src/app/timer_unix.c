@@ -0,0 +1,341 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  timer_unix.c
+** Module       :  app
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-16 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix app timers. Every timer shares one timerfd
+**                 in the app's epoll set, armed for the earliest
+**                 deadline in a binary min-heap.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "app.h"
+#include "app_unix.h"
+#include "timer_unix.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define NANOS_PER_SECOND 1000000000ull
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static bool open_timer_queue(UnixApp* app);
+static bool push_timer(UnixTimerQueue* queue, UnixTimer* timer);
+static void remove_timer_at(UnixTimerQueue* queue, size_t index);
+static void sift_timer_up(UnixTimerQueue* queue, size_t index);
+static void sift_timer_down(UnixTimerQueue* queue, size_t index);
+static void arm_timer_fd(UnixTimerQueue* queue);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+AppTimerHandle_opt add_app_timer(AppHandle handle, uint64_t intervalNanos, AppTimerCallback callback, void* userData)
+{
+    UnixApp* app = (UnixApp*)handle;
+
+    if (app == NULL || callback == NULL || intervalNanos == 0)
+    {
+        log_error("Invalid app handle, callback or interval");
+        return (AppTimerHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+    }
+
+    if (app->timerQueue.heap == NULL && !open_timer_queue(app))
+    {
+        return (AppTimerHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+    }
+
+    UnixTimer* timer = calloc(1, sizeof(UnixTimer));
+    timer->deadline = get_monotonic_nanos() + intervalNanos;
+    timer->interval = intervalNanos;
+    timer->callback = callback;
+    timer->userData = userData;
+
+    if (!push_timer(&app->timerQueue, timer))
+    {
+        log_error("Failed to grow the timer queue");
+        free(timer);
+        return (AppTimerHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+    }
+
+    if (timer->heapIndex == 0)
+    {
+        arm_timer_fd(&app->timerQueue);
+    }
+
+    return (AppTimerHandle_opt) { .value = (uintptr_t)timer, .is_some = true };
+}
+
+void remove_app_timer(AppHandle handle, AppTimerHandle timerHandle)
+{
+    UnixApp* app = (UnixApp*)handle;
+    UnixTimer* timer = (UnixTimer*)timerHandle;
+
+    if (app == NULL || timer == NULL)
+    {
+        log_error("Invalid app or timer handle");
+        return;
+    }
+
+    /* run_due_timers frees it once the callback returns */
+    if (timer->heapIndex == SIZE_MAX)
+    {
+        timer->isRemoved = true;
+        return;
+    }
+
+    bool wasFirst = timer->heapIndex == 0;
+
+    remove_timer_at(&app->timerQueue, timer->heapIndex);
+    free(timer);
+
+    if (wasFirst)
+    {
+        arm_timer_fd(&app->timerQueue);
+    }
+}
+
+void run_due_timers(UnixApp* app)
+{
+    UnixTimerQueue* queue = &app->timerQueue;
+
+    if (queue->count == 0)
+    {
+        return;
+    }
+
+    uint64_t now = get_monotonic_nanos();
+
+    if (queue->heap[0]->deadline > now)
+    {
+        return;
+    }
+
+    /* clear the expiration count so epoll stops reporting the fd */
+    uint64_t expirations;
+    while (read(queue->timerFd, &expirations, sizeof(expirations)) < 0 && errno == EINTR)
+    {
+    }
+
+    while (queue->count > 0 && queue->heap[0]->deadline <= now)
+    {
+        UnixTimer* timer = queue->heap[0];
+        remove_timer_at(queue, 0);
+
+        timer->heapIndex = SIZE_MAX;
+        timer->callback((AppHandle)app, (AppTimerHandle)timer, timer->userData);
+
+        if (timer->isRemoved)
+        {
+            free(timer);
+            continue;
+        }
+
+        /* keep the phase but skip intervals we were too late for */
+        timer->deadline += timer->interval;
+        if (timer->deadline <= now)
+        {
+            timer->deadline += ((now - timer->deadline) / timer->interval + 1) * timer->interval;
+        }
+
+        if (!push_timer(queue, timer))
+        {
+            log_error("Failed to reschedule a timer");
+            free(timer);
+        }
+    }
+
+    arm_timer_fd(queue);
+}
+
+int64_t get_next_timer_deadline(UnixApp* app)
+{
+    if (app->timerQueue.count == 0)
+    {
+        return -1;
+    }
+
+    return (int64_t)app->timerQueue.heap[0]->deadline;
+}
+
+uint64_t get_monotonic_nanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * NANOS_PER_SECOND + (uint64_t)now.tv_nsec;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static bool open_timer_queue(UnixApp* app)
+{
+    UnixTimerQueue* queue = &app->timerQueue;
+
+    queue->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (queue->timerFd < 0)
+    {
+        log_error("Failed to create a timerfd");
+        return false;
+    }
+
+    struct epoll_event timerEvent = { .events = EPOLLIN, .data.u32 = UNIX_APP_SOURCE_TIMER };
+    if (epoll_ctl(app->epollFd, EPOLL_CTL_ADD, queue->timerFd, &timerEvent) < 0)
+    {
+        log_error("Failed to watch the timerfd");
+        close(queue->timerFd);
+        queue->timerFd = -1;
+        return false;
+    }
+
+    queue->capacity = 16;
+    queue->heap = malloc(queue->capacity * sizeof(UnixTimer*));
+    if (queue->heap == NULL)
+    {
+        /* a NULL heap means the queue isn't open, so the next add_app_timer tries again */
+        log_error("Failed to allocate the timer heap");
+        epoll_ctl(app->epollFd, EPOLL_CTL_DEL, queue->timerFd, NULL);
+        close(queue->timerFd);
+        queue->timerFd = -1;
+        queue->capacity = 0;
+        return false;
+    }
+
+    return true;
+}
+
+static bool push_timer(UnixTimerQueue* queue, UnixTimer* timer)
+{
+    if (queue->count == queue->capacity)
+    {
+        UnixTimer** heap = realloc(queue->heap, queue->capacity * 2 * sizeof(UnixTimer*));
+        if (heap == NULL)
+        {
+            return false;
+        }
+
+        queue->heap = heap;
+        queue->capacity *= 2;
+    }
+
+    timer->heapIndex = queue->count;
+    queue->heap[queue->count++] = timer;
+    sift_timer_up(queue, timer->heapIndex);
+
+    return true;
+}
+
+static void remove_timer_at(UnixTimerQueue* queue, size_t index)
+{
+    UnixTimer* last = queue->heap[--queue->count];
+
+    if (index == queue->count)
+    {
+        return;
+    }
+
+    /* the moved timer may belong above or below the hole */
+    queue->heap[index] = last;
+    last->heapIndex = index;
+    sift_timer_up(queue, index);
+    sift_timer_down(queue, last->heapIndex);
+}
+
+static void sift_timer_up(UnixTimerQueue* queue, size_t index)
+{
+    UnixTimer* timer = queue->heap[index];
+
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (queue->heap[parent]->deadline <= timer->deadline)
+        {
+            break;
+        }
+
+        queue->heap[index] = queue->heap[parent];
+        queue->heap[index]->heapIndex = index;
+        index = parent;
+    }
+
+    queue->heap[index] = timer;
+    timer->heapIndex = index;
+}
+
+static void sift_timer_down(UnixTimerQueue* queue, size_t index)
+{
+    UnixTimer* timer = queue->heap[index];
+
+    while (true)
+    {
+        size_t child = index * 2 + 1;
+        if (child >= queue->count)
+        {
+            break;
+        }
+
+        if (child + 1 < queue->count && queue->heap[child + 1]->deadline < queue->heap[child]->deadline)
+        {
+            child++;
+        }
+
+        if (timer->deadline <= queue->heap[child]->deadline)
+        {
+            break;
+        }
+
+        queue->heap[index] = queue->heap[child];
+        queue->heap[index]->heapIndex = index;
+        index = child;
+    }
+
+    queue->heap[index] = timer;
+    timer->heapIndex = index;
+}
+
+static void arm_timer_fd(UnixTimerQueue* queue)
+{
+    /* a zero it_value disarms the timer */
+    struct itimerspec spec = { 0 };
+
+    if (queue->count > 0)
+    {
+        uint64_t deadline = queue->heap[0]->deadline;
+        spec.it_value.tv_sec = (time_t)(deadline / NANOS_PER_SECOND);
+        spec.it_value.tv_nsec = (long)(deadline % NANOS_PER_SECOND);
+    }
+
+    timerfd_settime(queue->timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
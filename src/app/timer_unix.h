@@ -0,0 +1,71 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  timer_unix.h
+** Module       :  app
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-16 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix app timers
+**
+***************************************************************/
+
+#ifndef TIMER_UNIX_H
+#define TIMER_UNIX_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include "../util/util.h"
+#include "app.h"
+#include "app_unix.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+#ifdef __unix
+
+    typedef struct UnixTimer
+    {
+        /* CLOCK_MONOTONIC nanoseconds */
+        uint64_t deadline;
+        uint64_t interval;
+
+        AppTimerCallback callback;
+        void* userData;
+
+        /* position in the heap, SIZE_MAX while the timer is firing */
+        size_t heapIndex;
+
+        /* set when the timer is removed from its own callback */
+        bool isRemoved;
+    } UnixTimer;
+
+#endif
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+#ifdef __unix
+
+    /* fires every timer whose deadline has passed and re-arms the timerfd */
+    void run_due_timers(UnixApp* app);
+
+    /* CLOCK_MONOTONIC nanoseconds, -1 without timers */
+    int64_t get_next_timer_deadline(UnixApp* app);
+
+    uint64_t get_monotonic_nanos();
+
+#endif
+
+#endif /* TIMER_UNIX_H */
@@ -0,0 +1,472 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  element.c
+** Module       :  element
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Element tree storage and structure.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "element.h"
+#include "element_tree.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define INITIAL_ELEMENT_CAPACITY 64
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static bool grow_element_slots(ElementTree* tree);
+static bool grow_element_array(void** array, size_t elementSize, uint32_t capacity);
+static uint32_t allocate_element_slot(ElementTree* tree);
+static void free_element_slot(ElementTree* tree, uint32_t index);
+static void unlink_element(ElementTree* tree, uint32_t index);
+static ElementHandle_opt get_linked_element(ElementTree* tree, uint32_t index);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+ElementTreeHandle_opt create_element_tree()
+{
+    ElementTree* tree = calloc(1, sizeof(ElementTree));
+    if (tree == NULL)
+    {
+        log_error("Failed to allocate an element tree");
+        return (ElementTreeHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+    }
+
+    tree->freeSlot = ELEMENT_NONE;
+
+    tree->root = allocate_element_slot(tree);
+    if (tree->root == ELEMENT_NONE)
+    {
+        destroy_element_tree((ElementTreeHandle)tree);
+        return (ElementTreeHandle_opt) { .value = (uintptr_t)0, .is_some = false };
+    }
+
+    return (ElementTreeHandle_opt) { .value = (uintptr_t)tree, .is_some = true };
+}
+
+void destroy_element_tree(ElementTreeHandle handle)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    if (tree == NULL)
+    {
+        return;
+    }
+
+    free(tree->generations);
+    free(tree->parents);
+    free(tree->firstChildren);
+    free(tree->lastChildren);
+    free(tree->nextSiblings);
+    free(tree->previousSiblings);
+    free(tree->rects);
+    free(tree->styles);
+    free(tree->layouts);
+    free(tree->contentSizes);
+    free(tree->layoutConstraints);
+    free(tree->layoutFlags);
+    free(tree->queuedLayouts);
+    free(tree->layoutItems);
+
+    #ifdef __unix
+        destroy_work_pool(tree->layoutPool);
+        free(tree->layoutClaims);
+    #endif
+
+    free(tree);
+}
+
+ElementHandle get_root_element(ElementTreeHandle handle)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    if (tree == NULL)
+    {
+        log_error("Invalid element tree handle");
+        return 0;
+    }
+
+    return ELEMENT_HANDLE(tree->root, tree->generations[tree->root]);
+}
+
+ElementHandle_opt create_element(ElementTreeHandle handle, ElementHandle parent)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t parentIndex;
+
+    if (tree == NULL || !resolve_element(tree, parent, &parentIndex))
+    {
+        log_error("Invalid element tree or parent handle");
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    uint32_t index = allocate_element_slot(tree);
+    if (index == ELEMENT_NONE)
+    {
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    /* append, so children keep the order they were created in */
+    uint32_t last = tree->lastChildren[parentIndex];
+
+    tree->parents[index] = parentIndex;
+    tree->previousSiblings[index] = last;
+
+    if (last == ELEMENT_NONE)
+    {
+        tree->firstChildren[parentIndex] = index;
+    }
+    else
+    {
+        tree->nextSiblings[last] = index;
+    }
+
+    tree->lastChildren[parentIndex] = index;
+
+    /* the new element starts out dirty, its parent has to make room for it */
+    invalidate_element_layout(tree, parentIndex);
+
+    return (ElementHandle_opt) { .value = ELEMENT_HANDLE(index, tree->generations[index]), .is_some = true };
+}
+
+void destroy_element(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return;
+    }
+
+    if (index == tree->root)
+    {
+        log_error("The root element lives as long as its tree");
+        return;
+    }
+
+    /* the parent lays out without it, anything queued inside is skipped once its handle is stale */
+    invalidate_element_layout(tree, tree->parents[index]);
+    unlink_element(tree, index);
+
+    /* post order without a stack, deep trees can't overflow anything. a freed leaf is always its parent's first child */
+    uint32_t current = index;
+    while (true)
+    {
+        while (tree->firstChildren[current] != ELEMENT_NONE)
+        {
+            current = tree->firstChildren[current];
+        }
+
+        if (current == index)
+        {
+            free_element_slot(tree, current);
+            break;
+        }
+
+        uint32_t parent = tree->parents[current];
+        uint32_t next = tree->nextSiblings[current];
+
+        tree->firstChildren[parent] = next;
+        free_element_slot(tree, current);
+
+        current = next != ELEMENT_NONE ? next : parent;
+    }
+}
+
+bool is_element_valid(ElementTreeHandle handle, ElementHandle element)
+{
+    uint32_t index;
+    return handle != 0 && resolve_element((ElementTree*)handle, element, &index);
+}
+
+size_t get_element_count(ElementTreeHandle handle)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    return tree != NULL ? tree->elementCount : 0;
+}
+
+ElementHandle_opt get_element_parent(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    return get_linked_element(tree, tree->parents[index]);
+}
+
+ElementHandle_opt get_element_first_child(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    return get_linked_element(tree, tree->firstChildren[index]);
+}
+
+ElementHandle_opt get_element_next_sibling(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    return get_linked_element(tree, tree->nextSiblings[index]);
+}
+
+void set_element_rect(ElementTreeHandle handle, ElementHandle element, ElementRect rect)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return;
+    }
+
+    tree->rects[index] = rect;
+}
+
+ElementRect get_element_rect(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return (ElementRect) { 0 };
+    }
+
+    return tree->rects[index];
+}
+
+void set_element_style(ElementTreeHandle handle, ElementHandle element, uint32_t style)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return;
+    }
+
+    tree->styles[index] = style;
+}
+
+uint32_t get_element_style(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return 0;
+    }
+
+    return tree->styles[index];
+}
+
+bool resolve_element(const ElementTree* tree, ElementHandle element, uint32_t* index)
+{
+    uint32_t slot = ELEMENT_INDEX(element);
+    uint32_t generation = ELEMENT_GENERATION(element);
+
+    /* a live generation is never 0, so this also rejects the 0 handle */
+    if (slot >= tree->slotCount || !IS_ELEMENT_SLOT_LIVE(generation) || tree->generations[slot] != generation)
+    {
+        return false;
+    }
+
+    *index = slot;
+    return true;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static bool grow_element_slots(ElementTree* tree)
+{
+    uint32_t capacity = tree->capacity == 0 ? INITIAL_ELEMENT_CAPACITY : tree->capacity * 2;
+
+    /* the top index is kept free for ELEMENT_NONE */
+    if (capacity <= tree->capacity || capacity == ELEMENT_NONE)
+    {
+        return false;
+    }
+
+    /* each array is swapped in as soon as it has grown, so a failure part way leaves all of them at least the old capacity */
+    bool isGrown = grow_element_array((void**)&tree->generations, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->parents, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->firstChildren, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->lastChildren, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->nextSiblings, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->previousSiblings, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->rects, sizeof(ElementRect), capacity)
+        && grow_element_array((void**)&tree->styles, sizeof(uint32_t), capacity)
+        && grow_element_array((void**)&tree->layouts, sizeof(ElementLayout), capacity)
+        && grow_element_array((void**)&tree->contentSizes, sizeof(ElementSize), capacity)
+        && grow_element_array((void**)&tree->layoutConstraints, sizeof(ElementSize), capacity)
+        && grow_element_array((void**)&tree->layoutFlags, sizeof(uint8_t), capacity);
+
+    #ifdef __unix
+        isGrown = isGrown && grow_element_array((void**)&tree->layoutClaims, sizeof(_Atomic(uint32_t)), capacity);
+    #endif
+
+    if (!isGrown)
+    {
+        return false;
+    }
+
+    tree->capacity = capacity;
+    return true;
+}
+
+static bool grow_element_array(void** array, size_t elementSize, uint32_t capacity)
+{
+    void* grown = realloc(*array, (size_t)capacity * elementSize);
+    if (grown == NULL)
+    {
+        return false;
+    }
+
+    *array = grown;
+    return true;
+}
+
+static uint32_t allocate_element_slot(ElementTree* tree)
+{
+    uint32_t index = tree->freeSlot;
+
+    if (index != ELEMENT_NONE)
+    {
+        tree->freeSlot = tree->nextSiblings[index];
+    }
+    else
+    {
+        if (tree->slotCount == tree->capacity && !grow_element_slots(tree))
+        {
+            log_error("Failed to grow the element tree past %u elements", tree->capacity);
+            return ELEMENT_NONE;
+        }
+
+        index = tree->slotCount++;
+        tree->generations[index] = 0;
+    }
+
+    tree->generations[index]++;
+    tree->parents[index] = ELEMENT_NONE;
+    tree->firstChildren[index] = ELEMENT_NONE;
+    tree->lastChildren[index] = ELEMENT_NONE;
+    tree->nextSiblings[index] = ELEMENT_NONE;
+    tree->previousSiblings[index] = ELEMENT_NONE;
+    tree->rects[index] = (ElementRect) { 0 };
+    tree->styles[index] = 0;
+    tree->layouts[index] = (ElementLayout) { .direction = ELEMENT_LAYOUT_COLUMN, .width = ELEMENT_SIZE_AUTO, .height = ELEMENT_SIZE_AUTO };
+    tree->contentSizes[index] = (ElementSize) { 0 };
+    tree->layoutConstraints[index] = (ElementSize) { 0 };
+    tree->layoutFlags[index] = ELEMENT_LAYOUT_DIRTY;
+
+    #ifdef __unix
+        /* passes start at 1, so a new slot is never already claimed */
+        atomic_init(&tree->layoutClaims[index], 0);
+    #endif
+
+    tree->elementCount++;
+    return index;
+}
+
+static void free_element_slot(ElementTree* tree, uint32_t index)
+{
+    /* back to even, which also turns away every handle to the old element */
+    tree->generations[index]++;
+    tree->nextSiblings[index] = tree->freeSlot;
+    tree->freeSlot = index;
+
+    tree->elementCount--;
+}
+
+static void unlink_element(ElementTree* tree, uint32_t index)
+{
+    uint32_t parent = tree->parents[index];
+    uint32_t previous = tree->previousSiblings[index];
+    uint32_t next = tree->nextSiblings[index];
+
+    if (previous == ELEMENT_NONE)
+    {
+        tree->firstChildren[parent] = next;
+    }
+    else
+    {
+        tree->nextSiblings[previous] = next;
+    }
+
+    if (next == ELEMENT_NONE)
+    {
+        tree->lastChildren[parent] = previous;
+    }
+    else
+    {
+        tree->previousSiblings[next] = previous;
+    }
+
+    tree->parents[index] = ELEMENT_NONE;
+    tree->previousSiblings[index] = ELEMENT_NONE;
+    tree->nextSiblings[index] = ELEMENT_NONE;
+}
+
+static ElementHandle_opt get_linked_element(ElementTree* tree, uint32_t index)
+{
+    if (index == ELEMENT_NONE)
+    {
+        return (ElementHandle_opt) { .value = 0, .is_some = false };
+    }
+
+    return (ElementHandle_opt) { .value = ELEMENT_HANDLE(index, tree->generations[index]), .is_some = true };
+}
@@ -8,7 +8,7 @@
 ** Author       :  SH
 ** Created      :  2025-01-08 (YYYY-MM-DD)
 ** License      :  MIT
-** Description  :  A header file template.
+** Description  :  Retained trees of user interface elements.
 **
 ***************************************************************/
 
@@ -20,21 +20,130 @@
 ***************************************************************/
 
 #include <stdint.h>
+#include <stddef.h>
 #include "../util/util.h"
 
 /***************************************************************
 ** MARK: CONSTANTS & MACROS
 ***************************************************************/
 
+/* a layout width or height that fits the content */
+#define ELEMENT_SIZE_AUTO (-1.0f)
+
 /***************************************************************
 ** MARK: TYPEDEFS
 ***************************************************************/
 
-typedef uintptr_t ElementHandle;
+typedef uintptr_t ElementTreeHandle;
+typedef OPTION(ElementTreeHandle) ElementTreeHandle_opt;
+
+/*
+** slot index in the low 32 bits, the slot's generation in the high 32.
+** slots are reused once their element is destroyed, and the generation
+** changing is how an old handle is told apart. 0 is never a valid handle.
+*/
+typedef uint64_t ElementHandle;
 typedef OPTION(ElementHandle) ElementHandle_opt;
 
+/* relative to the parent's top left corner */
+typedef struct
+{
+    float x;
+    float y;
+    float width;
+    float height;
+} ElementRect;
+
+typedef struct
+{
+    float width;
+    float height;
+} ElementSize;
+
+typedef enum
+{
+    /* children one below the other */
+    ELEMENT_LAYOUT_COLUMN,
+
+    /* children side by side */
+    ELEMENT_LAYOUT_ROW,
+
+    /* children on top of each other */
+    ELEMENT_LAYOUT_STACK
+} ElementLayoutDirection;
+
+typedef struct
+{
+    ElementLayoutDirection direction;
+
+    /* ELEMENT_SIZE_AUTO fits the content, up to what the parent has room for */
+    float width;
+    float height;
+
+    /* share of the space a row or column parent has left over, 0 keeps the fitted size */
+    float grow;
+
+    float padding;
+    float gap;
+} ElementLayout;
+
 /***************************************************************
 ** MARK: FUNCTION DEFS
 ***************************************************************/
 
-#endif /* ELEMENT_H */
\ No newline at end of file
+/* a tree starts out with a root element, which lives as long as the tree */
+ElementTreeHandle_opt create_element_tree();
+void destroy_element_tree(ElementTreeHandle tree);
+
+ElementHandle get_root_element(ElementTreeHandle tree);
+
+/* elements are added as the last child of parent */
+ElementHandle_opt create_element(ElementTreeHandle tree, ElementHandle parent);
+
+/* destroys the element and everything below it, every handle to them goes stale */
+void destroy_element(ElementTreeHandle tree, ElementHandle element);
+
+/* false for stale handles and handles from another tree's slots */
+bool is_element_valid(ElementTreeHandle tree, ElementHandle element);
+
+/* live elements, including the root */
+size_t get_element_count(ElementTreeHandle tree);
+
+/* none at the ends of the tree, children are visited first child then next sibling */
+ElementHandle_opt get_element_parent(ElementTreeHandle tree, ElementHandle element);
+ElementHandle_opt get_element_first_child(ElementTreeHandle tree, ElementHandle element);
+ElementHandle_opt get_element_next_sibling(ElementTreeHandle tree, ElementHandle element);
+
+/* layout_element_tree overwrites rects of the elements it lays out */
+void set_element_rect(ElementTreeHandle tree, ElementHandle element, ElementRect rect);
+ElementRect get_element_rect(ElementTreeHandle tree, ElementHandle element);
+
+/* index into whatever style table the renderer uses, 0 by default */
+void set_element_style(ElementTreeHandle tree, ElementHandle element, uint32_t style);
+uint32_t get_element_style(ElementTreeHandle tree, ElementHandle element);
+
+/*
+** new elements are an auto sized column. an element with a fixed width and
+** height that doesn't grow is a layout boundary: nothing inside it can
+** change its size, so changes inside only lay out its own subtree again.
+*/
+void set_element_layout(ElementTreeHandle tree, ElementHandle element, ElementLayout layout);
+ElementLayout get_element_layout(ElementTreeHandle tree, ElementHandle element);
+
+/* what a childless element measures, such as its text */
+void set_element_content_size(ElementTreeHandle tree, ElementHandle element, ElementSize size);
+
+/*
+** sets the rect of every element that changed since the last call, with
+** the root sized to width x height. subtrees whose layout and constraints
+** are unchanged keep their rects without being visited.
+*/
+void layout_element_tree(ElementTreeHandle tree, float width, float height);
+
+/*
+** with more than 1 thread, layout boundaries are laid out in parallel on a
+** work stealing pool, the calling thread included. 1 by default.
+*/
+void set_element_layout_threads(ElementTreeHandle tree, uint32_t threadCount);
+
+#endif /* ELEMENT_H */
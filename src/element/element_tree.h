@@ -0,0 +1,122 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  element_tree.h
+** Module       :  element
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Storage behind an ElementTreeHandle, shared by
+**                 the element module's source files.
+**
+***************************************************************/
+
+#ifndef ELEMENT_TREE_H
+#define ELEMENT_TREE_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "element.h"
+
+#ifdef __unix
+
+    #include <stdatomic.h>
+    #include "../util/work_pool_unix.h"
+
+#endif
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/* end of a parent, child or sibling link */
+#define ELEMENT_NONE UINT32_MAX
+
+#define ELEMENT_HANDLE(index, generation) (((uint64_t)(generation) << 32) | (uint64_t)(index))
+#define ELEMENT_INDEX(handle) ((uint32_t)((handle) & 0xFFFFFFFFu))
+#define ELEMENT_GENERATION(handle) ((uint32_t)((handle) >> 32))
+
+/* odd generations are live, so a slot's generation also says whether it is in use */
+#define IS_ELEMENT_SLOT_LIVE(generation) (((generation) & 1u) != 0)
+
+/* layoutFlags bits */
+#define ELEMENT_LAYOUT_DIRTY 0x01u
+#define ELEMENT_LAYOUT_QUEUED 0x02u
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/*
+** one array per field, indexed by slot, so a pass that only reads links
+** or rects streams through just those. children form a doubly linked
+** list so elements unlink in constant time.
+*/
+typedef struct ElementTree
+{
+    uint32_t* generations;
+    uint32_t* parents;
+    uint32_t* firstChildren;
+    uint32_t* lastChildren;
+    uint32_t* nextSiblings;
+    uint32_t* previousSiblings;
+    ElementRect* rects;
+    uint32_t* styles;
+
+    /* layout inputs */
+    ElementLayout* layouts;
+    ElementSize* contentSizes;
+
+    /* the constraints each element was last laid out with, its rect is still right for them unless it is dirty */
+    ElementSize* layoutConstraints;
+    uint8_t* layoutFlags;
+
+    /* slots allocated, and slots ever handed out */
+    uint32_t capacity;
+    uint32_t slotCount;
+
+    uint32_t elementCount;
+
+    /* destroyed slots, chained through nextSiblings */
+    uint32_t freeSlot;
+
+    uint32_t root;
+
+    /* dirty layout boundaries (and the root), laid out on their own by the next pass */
+    ElementHandle* queuedLayouts;
+    uint32_t queuedLayoutCount;
+    uint32_t queuedLayoutCapacity;
+
+    /* the root and the queued boundaries as slot indices, what a pass starts from */
+    uint32_t* layoutItems;
+
+    /* what the root is being laid out with */
+    ElementSize rootSize;
+
+    #ifdef __unix
+        /* lays out boundaries in parallel, NULL when layout stays on the calling thread */
+        WorkPool* layoutPool;
+
+        /* the last pass each boundary was claimed in, so only one thread lays it out */
+        _Atomic(uint32_t)* layoutClaims;
+        uint32_t layoutPass;
+    #endif
+} ElementTree;
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+/* false if the handle is stale, otherwise its slot goes into index */
+bool resolve_element(const ElementTree* tree, ElementHandle element, uint32_t* index);
+
+/* flags the element and its ancestors up to the nearest layout boundary, which is queued */
+void invalidate_element_layout(ElementTree* tree, uint32_t index);
+
+#endif /* ELEMENT_TREE_H */
@@ -0,0 +1,519 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  layout.c
+** Module       :  element
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-19 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Incremental row, column and stack layout over
+**                 the element tree. Changes only dirty the path up
+**                 to the nearest fixed size element, and a pass
+**                 skips any subtree whose constraints are the same
+**                 as last time. Fixed size elements don't depend
+**                 on anything outside them, so with a work pool
+**                 each one is laid out as its own job, and jobs
+**                 only ever write their own subtree's slots.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "element.h"
+#include "element_tree.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define INITIAL_QUEUED_LAYOUT_CAPACITY 16
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static bool is_layout_boundary(const ElementTree* tree, uint32_t index);
+static bool queue_element_layout(ElementTree* tree, uint32_t index);
+static void start_layout_pass(ElementTree* tree);
+static bool claim_layout_boundary(ElementTree* tree, uint32_t index);
+static void run_layout_items(ElementTree* tree, const uint32_t* items, uint32_t count);
+static void run_layout_item(void* context, uint32_t index);
+static void layout_child(ElementTree* tree, uint32_t index, float maxWidth, float maxHeight);
+static ElementSize get_laid_out_size(const ElementTree* tree, uint32_t index);
+static void layout_element(ElementTree* tree, uint32_t index, float maxWidth, float maxHeight);
+static void layout_stacked_children(ElementTree* tree, uint32_t index, float innerWidth, float innerHeight, ElementSize* content);
+static void layout_lined_children(ElementTree* tree, uint32_t index, float innerWidth, float innerHeight, ElementSize* content);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+void set_element_layout(ElementTreeHandle handle, ElementHandle element, ElementLayout layout)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return;
+    }
+
+    tree->layouts[index] = layout;
+
+    /* its size or grow may have changed, so the parent lays out again whether or not it is a boundary */
+    tree->layoutFlags[index] |= ELEMENT_LAYOUT_DIRTY;
+    invalidate_element_layout(tree, index == tree->root ? index : tree->parents[index]);
+}
+
+ElementLayout get_element_layout(ElementTreeHandle handle, ElementHandle element)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return (ElementLayout) { 0 };
+    }
+
+    return tree->layouts[index];
+}
+
+void set_element_content_size(ElementTreeHandle handle, ElementHandle element, ElementSize size)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    uint32_t index;
+
+    if (tree == NULL || !resolve_element(tree, element, &index))
+    {
+        log_error("Invalid element tree or element handle");
+        return;
+    }
+
+    if (tree->contentSizes[index].width == size.width && tree->contentSizes[index].height == size.height)
+    {
+        return;
+    }
+
+    tree->contentSizes[index] = size;
+    invalidate_element_layout(tree, index);
+}
+
+void layout_element_tree(ElementTreeHandle handle, float width, float height)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    if (tree == NULL)
+    {
+        log_error("Invalid element tree handle");
+        return;
+    }
+
+    /* the root first, so on one thread the boundaries it reaches are clean by the time their turn comes */
+    uint32_t rootItem = tree->root;
+    uint32_t* items = tree->queuedLayoutCount > 0 ? tree->layoutItems : &rootItem;
+    uint32_t count = 0;
+
+    items[count++] = tree->root;
+    tree->rootSize = (ElementSize) { width, height };
+
+    start_layout_pass(tree);
+
+    /* claimed up front, so the root pass leaves them to their own items */
+    for (uint32_t i = 0; i < tree->queuedLayoutCount; i++)
+    {
+        uint32_t index;
+        if (!resolve_element(tree, tree->queuedLayouts[i], &index))
+        {
+            continue;
+        }
+
+        tree->layoutFlags[index] &= ~ELEMENT_LAYOUT_QUEUED;
+
+        /* no longer a boundary since it was queued, its parent was dirtied with it so the root pass gets there */
+        if (!is_layout_boundary(tree, index))
+        {
+            continue;
+        }
+
+        if (claim_layout_boundary(tree, index))
+        {
+            items[count++] = index;
+        }
+    }
+
+    tree->queuedLayoutCount = 0;
+
+    run_layout_items(tree, items, count);
+}
+
+void set_element_layout_threads(ElementTreeHandle handle, uint32_t threadCount)
+{
+    ElementTree* tree = (ElementTree*)handle;
+    if (tree == NULL)
+    {
+        log_error("Invalid element tree handle");
+        return;
+    }
+
+    #ifdef __unix
+        destroy_work_pool(tree->layoutPool);
+        tree->layoutPool = threadCount > 1 ? create_work_pool(threadCount) : NULL;
+    #else
+        if (threadCount > 1)
+        {
+            log_warn("Parallel layout isn't supported on this platform, laying out on the calling thread");
+        }
+    #endif
+}
+
+void invalidate_element_layout(ElementTree* tree, uint32_t index)
+{
+    /* a dirty element's ancestors are already dirty up to its boundary, so the walk stops at the first one */
+    while (true)
+    {
+        tree->layoutFlags[index] |= ELEMENT_LAYOUT_DIRTY;
+
+        if (index == tree->root)
+        {
+            return;
+        }
+
+        if (is_layout_boundary(tree, index) && queue_element_layout(tree, index))
+        {
+            return;
+        }
+
+        index = tree->parents[index];
+
+        if ((tree->layoutFlags[index] & ELEMENT_LAYOUT_DIRTY) != 0)
+        {
+            return;
+        }
+    }
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static bool is_layout_boundary(const ElementTree* tree, uint32_t index)
+{
+    const ElementLayout* layout = &tree->layouts[index];
+
+    /* the root always takes the size it is laid out with */
+    return index != tree->root &&
+        layout->width != ELEMENT_SIZE_AUTO &&
+        layout->height != ELEMENT_SIZE_AUTO &&
+        layout->grow <= 0.0f;
+}
+
+static bool queue_element_layout(ElementTree* tree, uint32_t index)
+{
+    if ((tree->layoutFlags[index] & ELEMENT_LAYOUT_QUEUED) != 0)
+    {
+        return true;
+    }
+
+    if (tree->queuedLayoutCount == tree->queuedLayoutCapacity)
+    {
+        uint32_t capacity = tree->queuedLayoutCapacity == 0 ? INITIAL_QUEUED_LAYOUT_CAPACITY : tree->queuedLayoutCapacity * 2;
+        ElementHandle* queuedLayouts = realloc(tree->queuedLayouts, capacity * sizeof(ElementHandle));
+        if (queuedLayouts != NULL)
+        {
+            tree->queuedLayouts = queuedLayouts;
+        }
+
+        /* one more for the root */
+        uint32_t* layoutItems = realloc(tree->layoutItems, (capacity + 1) * sizeof(uint32_t));
+        if (layoutItems != NULL)
+        {
+            tree->layoutItems = layoutItems;
+        }
+
+        if (queuedLayouts == NULL || layoutItems == NULL)
+        {
+            /* still correct, the caller just keeps dirtying up to the root */
+            log_warn("Failed to queue a layout boundary");
+            return false;
+        }
+
+        tree->queuedLayoutCapacity = capacity;
+    }
+
+    tree->queuedLayouts[tree->queuedLayoutCount++] = ELEMENT_HANDLE(index, tree->generations[index]);
+    tree->layoutFlags[index] |= ELEMENT_LAYOUT_QUEUED;
+
+    return true;
+}
+
+static void start_layout_pass(ElementTree* tree)
+{
+    #ifdef __unix
+        if (tree->layoutPool != NULL && ++tree->layoutPass == 0)
+        {
+            /* wrapped, forget every old claim */
+            for (uint32_t i = 0; i < tree->slotCount; i++)
+            {
+                atomic_store_explicit(&tree->layoutClaims[i], 0, memory_order_relaxed);
+            }
+
+            tree->layoutPass = 1;
+        }
+    #endif
+}
+
+static bool claim_layout_boundary(ElementTree* tree, uint32_t index)
+{
+    /* anything else is laid out by its parent, claiming it would lay it out twice */
+    if (!is_layout_boundary(tree, index))
+    {
+        log_error("Only layout boundaries can be claimed");
+        return false;
+    }
+
+    #ifdef __unix
+        /* whoever swaps in this pass owns the boundary's subtree until the pass is over */
+        if (tree->layoutPool != NULL)
+        {
+            return atomic_exchange_explicit(&tree->layoutClaims[index], tree->layoutPass, memory_order_relaxed) != tree->layoutPass;
+        }
+    #endif
+
+    /* on one thread a boundary is just laid out again, and returns straight away when it is clean */
+    return true;
+}
+
+static void run_layout_items(ElementTree* tree, const uint32_t* items, uint32_t count)
+{
+    #ifdef __unix
+        if (tree->layoutPool != NULL)
+        {
+            run_work_pool(tree->layoutPool, run_layout_item, tree, items, count);
+            return;
+        }
+    #endif
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        run_layout_item(tree, items[i]);
+    }
+}
+
+/* every boundary item is already claimed by whoever queued or pushed it */
+static void run_layout_item(void* context, uint32_t index)
+{
+    ElementTree* tree = (ElementTree*)context;
+
+    if (index == tree->root)
+    {
+        /* a clean root with the same size returns straight away */
+        layout_element(tree, index, tree->rootSize.width, tree->rootSize.height);
+    }
+    else
+    {
+        /* a boundary's size doesn't depend on its constraints, so where it sits in its parent is still right */
+        layout_element(tree, index, tree->layoutConstraints[index].width, tree->layoutConstraints[index].height);
+    }
+}
+
+static void layout_child(ElementTree* tree, uint32_t index, float maxWidth, float maxHeight)
+{
+    if (!is_layout_boundary(tree, index))
+    {
+        layout_element(tree, index, maxWidth, maxHeight);
+        return;
+    }
+
+    if (!claim_layout_boundary(tree, index))
+    {
+        return;
+    }
+
+    #ifdef __unix
+        /* the parent only needs the boundary's fixed size, so it carries on while another thread fills it in */
+        if (tree->layoutPool != NULL &&
+            (tree->layoutFlags[index] & ELEMENT_LAYOUT_DIRTY) != 0 &&
+            push_work(tree->layoutPool, index))
+        {
+            return;
+        }
+    #endif
+
+    layout_element(tree, index, maxWidth, maxHeight);
+}
+
+/* a boundary's rect may still be being written by its job, its size is in its layout */
+static ElementSize get_laid_out_size(const ElementTree* tree, uint32_t index)
+{
+    if (is_layout_boundary(tree, index))
+    {
+        return (ElementSize) { tree->layouts[index].width, tree->layouts[index].height };
+    }
+
+    return (ElementSize) { tree->rects[index].width, tree->rects[index].height };
+}
+
+static void layout_element(ElementTree* tree, uint32_t index, float maxWidth, float maxHeight)
+{
+    uint8_t* flags = &tree->layoutFlags[index];
+    ElementSize* constraints = &tree->layoutConstraints[index];
+
+    if ((*flags & ELEMENT_LAYOUT_DIRTY) == 0 &&
+        (is_layout_boundary(tree, index) || (constraints->width == maxWidth && constraints->height == maxHeight)))
+    {
+        return;
+    }
+
+    const ElementLayout* layout = &tree->layouts[index];
+
+    /* the root and growing children take all the space they are given along their parent's direction */
+    uint32_t parent = tree->parents[index];
+    ElementLayoutDirection parentDirection = parent == ELEMENT_NONE ? ELEMENT_LAYOUT_STACK : tree->layouts[parent].direction;
+    bool isGrowing = layout->grow > 0.0f;
+    bool fillsWidth = index == tree->root || (isGrowing && parentDirection == ELEMENT_LAYOUT_ROW);
+    bool fillsHeight = index == tree->root || (isGrowing && parentDirection == ELEMENT_LAYOUT_COLUMN);
+
+    float width = fillsWidth ? maxWidth : layout->width;
+    float height = fillsHeight ? maxHeight : layout->height;
+
+    float innerWidth = (width != ELEMENT_SIZE_AUTO ? width : maxWidth) - 2.0f * layout->padding;
+    float innerHeight = (height != ELEMENT_SIZE_AUTO ? height : maxHeight) - 2.0f * layout->padding;
+    innerWidth = innerWidth > 0.0f ? innerWidth : 0.0f;
+    innerHeight = innerHeight > 0.0f ? innerHeight : 0.0f;
+
+    ElementSize content;
+
+    if (tree->firstChildren[index] == ELEMENT_NONE)
+    {
+        content = tree->contentSizes[index];
+    }
+    else if (layout->direction == ELEMENT_LAYOUT_STACK)
+    {
+        layout_stacked_children(tree, index, innerWidth, innerHeight, &content);
+    }
+    else
+    {
+        layout_lined_children(tree, index, innerWidth, innerHeight, &content);
+    }
+
+    if (width == ELEMENT_SIZE_AUTO)
+    {
+        width = content.width + 2.0f * layout->padding;
+        width = width < maxWidth ? width : maxWidth;
+    }
+
+    if (height == ELEMENT_SIZE_AUTO)
+    {
+        height = content.height + 2.0f * layout->padding;
+        height = height < maxHeight ? height : maxHeight;
+    }
+
+    tree->rects[index].width = width;
+    tree->rects[index].height = height;
+
+    *constraints = (ElementSize) { maxWidth, maxHeight };
+    *flags &= ~ELEMENT_LAYOUT_DIRTY;
+}
+
+static void layout_stacked_children(ElementTree* tree, uint32_t index, float innerWidth, float innerHeight, ElementSize* content)
+{
+    float padding = tree->layouts[index].padding;
+
+    *content = (ElementSize) { 0 };
+
+    for (uint32_t child = tree->firstChildren[index]; child != ELEMENT_NONE; child = tree->nextSiblings[child])
+    {
+        layout_child(tree, child, innerWidth, innerHeight);
+
+        tree->rects[child].x = padding;
+        tree->rects[child].y = padding;
+
+        ElementSize size = get_laid_out_size(tree, child);
+        content->width = size.width > content->width ? size.width : content->width;
+        content->height = size.height > content->height ? size.height : content->height;
+    }
+}
+
+static void layout_lined_children(ElementTree* tree, uint32_t index, float innerWidth, float innerHeight, ElementSize* content)
+{
+    const ElementLayout* layout = &tree->layouts[index];
+    bool isRow = layout->direction == ELEMENT_LAYOUT_ROW;
+    float innerMain = isRow ? innerWidth : innerHeight;
+
+    /* fitted children first, whatever is left is shared between the growing ones */
+    float used = 0.0f;
+    float totalGrow = 0.0f;
+    uint32_t count = 0;
+
+    for (uint32_t child = tree->firstChildren[index]; child != ELEMENT_NONE; child = tree->nextSiblings[child])
+    {
+        count++;
+
+        if (tree->layouts[child].grow > 0.0f)
+        {
+            totalGrow += tree->layouts[child].grow;
+            continue;
+        }
+
+        layout_child(tree, child, innerWidth, innerHeight);
+
+        ElementSize size = get_laid_out_size(tree, child);
+        used += isRow ? size.width : size.height;
+    }
+
+    used += layout->gap * (float)(count - 1);
+
+    float leftover = innerMain > used ? innerMain - used : 0.0f;
+    float cursor = layout->padding;
+    float cross = 0.0f;
+
+    for (uint32_t child = tree->firstChildren[index]; child != ELEMENT_NONE; child = tree->nextSiblings[child])
+    {
+        float grow = tree->layouts[child].grow;
+
+        if (grow > 0.0f)
+        {
+            float share = leftover * grow / totalGrow;
+            layout_element(tree, child, isRow ? share : innerWidth, isRow ? innerHeight : share);
+        }
+
+        ElementRect* rect = &tree->rects[child];
+        ElementSize size = get_laid_out_size(tree, child);
+
+        if (isRow)
+        {
+            rect->x = cursor;
+            rect->y = layout->padding;
+            cursor += size.width + layout->gap;
+            cross = size.height > cross ? size.height : cross;
+        }
+        else
+        {
+            rect->x = layout->padding;
+            rect->y = cursor;
+            cursor += size.height + layout->gap;
+            cross = size.width > cross ? size.width : cross;
+        }
+    }
+
+    float main = cursor - layout->gap - layout->padding;
+
+    *content = isRow ? (ElementSize) { main, cross } : (ElementSize) { cross, main };
+}
@@ -0,0 +1,108 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  event.h
+** Module       :  event
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-15 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  The Angelo event interface
+**
+***************************************************************/
+
+#ifndef EVENT_H
+#define EVENT_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../util/util.h"
+#include "../app/app.h"
+#include "../win/win.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+typedef enum
+{
+    ANGELO_EVENT_NONE,
+
+    /* the window is destroyed once this is queued, the handle only identifies it */
+    ANGELO_EVENT_WINDOW_CLOSE,
+
+    ANGELO_EVENT_WINDOW_RESIZE,
+    ANGELO_EVENT_WINDOW_EXPOSE,
+    ANGELO_EVENT_POINTER_MOTION,
+    ANGELO_EVENT_POINTER_BUTTON,
+    ANGELO_EVENT_KEY
+} AngeloEventType;
+
+/* fixed size so events can be copied out in bulk without allocating */
+typedef struct
+{
+    AngeloEventType type;
+
+    /* server time in milliseconds where the backend provides one, 0 otherwise */
+    uint32_t time;
+
+    WindowHandle window;
+
+    union
+    {
+        struct
+        {
+            int width;
+            int height;
+        } resize;
+
+        /* area that needs repainting */
+        WindowRect expose;
+
+        struct
+        {
+            int x;
+            int y;
+        } motion;
+
+        struct
+        {
+            int x;
+            int y;
+            uint32_t button;
+            bool isPressed;
+        } button;
+
+        struct
+        {
+            /* native keycode */
+            uint32_t keycode;
+            bool isPressed;
+        } key;
+    } data;
+} AngeloEvent;
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+/* 
+** run one dispatch pass and copy up to capacity queued events into the
+** caller's array, returning how many were written. events that don't fit
+** stay queued for the next call. these drive the app instead of run_app.
+*/
+size_t poll_events(AppHandle app, AngeloEvent* events, size_t capacity);
+
+/* as poll_events, but sleeps up to timeout milliseconds (-1 forever) while nothing is queued */
+size_t wait_events(AppHandle app, AngeloEvent* events, size_t capacity, int timeout);
+
+#endif /* EVENT_H */
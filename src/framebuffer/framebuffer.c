@@ -0,0 +1,56 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  framebuffer.c
+** Module       :  framebuffer
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Platform independent framebuffer sizing.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "framebuffer.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+size_t grow_framebuffer_capacity(size_t capacity, size_t required)
+{
+    if (required <= capacity)
+    {
+        return capacity;
+    }
+
+    /* the first allocation is exact, windows are rarely resized at all */
+    size_t grown = capacity + capacity / 2;
+
+    return grown > required ? grown : required;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
@@ -0,0 +1,43 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  framebuffer.h
+** Module       :  framebuffer
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Cpu framebuffers that are kept across frames
+**                 and resizes.
+**
+***************************************************************/
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stddef.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/* every platform draws 32 bit pixels, in rows without padding */
+#define FRAMEBUFFER_BYTES_PER_PIXEL 4
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+/* bytes to reserve so that required fits, growing geometrically so a live resize settles after a few allocations */
+size_t grow_framebuffer_capacity(size_t capacity, size_t required);
+
+#endif /* FRAMEBUFFER_H */
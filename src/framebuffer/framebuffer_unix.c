@@ -0,0 +1,222 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  framebuffer_unix.c
+** Module       :  framebuffer
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix framebuffer implementation
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+/* memfd_create */
+#define _GNU_SOURCE
+
+#include "framebuffer.h"
+#include "framebuffer_unix.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static bool reserve_framebuffer_memory(UnixFramebuffer* framebuffer, size_t capacity);
+static void release_framebuffer_memory(UnixFramebuffer* framebuffer);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+void init_unix_framebuffer(UnixFramebuffer* framebuffer, UnixFramebufferStorage storage, int frameCount)
+{
+    *framebuffer = (UnixFramebuffer) {
+        .storage = storage,
+        .frameCount = frameCount,
+        .shmId = -1,
+        .fd = -1
+    };
+}
+
+bool resize_unix_framebuffer(UnixFramebuffer* framebuffer, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        log_error("Invalid framebuffer size %d x %d", width, height);
+        return false;
+    }
+
+    size_t stride = (size_t)width * FRAMEBUFFER_BYTES_PER_PIXEL;
+    size_t frameSize = stride * (size_t)height;
+    size_t required = frameSize * (size_t)framebuffer->frameCount;
+
+    if (required > framebuffer->capacity && !reserve_framebuffer_memory(framebuffer, grow_framebuffer_capacity(framebuffer->capacity, required)))
+    {
+        log_error("Failed to allocate a %d x %d framebuffer", width, height);
+        return false;
+    }
+
+    framebuffer->width = width;
+    framebuffer->height = height;
+    framebuffer->stride = stride;
+    framebuffer->frameSize = frameSize;
+
+    return true;
+}
+
+uint8_t* get_unix_framebuffer_frame(UnixFramebuffer* framebuffer, int index)
+{
+    return framebuffer->memory + framebuffer->frameSize * (size_t)index;
+}
+
+void destroy_unix_framebuffer(UnixFramebuffer* framebuffer)
+{
+    release_framebuffer_memory(framebuffer);
+
+    if (framebuffer->fd >= 0)
+    {
+        close(framebuffer->fd);
+        framebuffer->fd = -1;
+    }
+
+    framebuffer->width = 0;
+    framebuffer->height = 0;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static bool reserve_framebuffer_memory(UnixFramebuffer* framebuffer, size_t capacity)
+{
+    /* the old frames are never copied, so they go first and peak usage stays at one block */
+    release_framebuffer_memory(framebuffer);
+    framebuffer->generation++;
+
+    switch (framebuffer->storage)
+    {
+        case UNIX_FRAMEBUFFER_HEAP:
+        {
+            framebuffer->memory = malloc(capacity);
+            if (framebuffer->memory == NULL)
+            {
+                return false;
+            }
+            break;
+        }
+        case UNIX_FRAMEBUFFER_SYSV_SHM:
+        {
+            /* segments can't grow, a bigger one replaces the old */
+            framebuffer->shmId = shmget(IPC_PRIVATE, capacity, IPC_CREAT | 0600);
+            if (framebuffer->shmId < 0)
+            {
+                return false;
+            }
+
+            void* memory = shmat(framebuffer->shmId, NULL, 0);
+
+            /* linux keeps a removed segment alive while anything is attached, so it can't leak if we crash */
+            shmctl(framebuffer->shmId, IPC_RMID, NULL);
+
+            if (memory == (void*)-1)
+            {
+                framebuffer->shmId = -1;
+                return false;
+            }
+
+            framebuffer->memory = memory;
+            break;
+        }
+        case UNIX_FRAMEBUFFER_MEMFD:
+        {
+            /* the file outlives its mappings, so a pool made from it only ever has to be resized */
+            if (framebuffer->fd < 0)
+            {
+                framebuffer->fd = memfd_create("angelo-framebuffer", MFD_CLOEXEC);
+                if (framebuffer->fd < 0)
+                {
+                    return false;
+                }
+            }
+
+            /* pools made from the file may cover all of it, so it never shrinks */
+            struct stat info;
+            if (fstat(framebuffer->fd, &info) == 0 && (size_t)info.st_size > capacity)
+            {
+                capacity = (size_t)info.st_size;
+            }
+
+            if (ftruncate(framebuffer->fd, (off_t)capacity) < 0)
+            {
+                return false;
+            }
+
+            void* memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, framebuffer->fd, 0);
+            if (memory == MAP_FAILED)
+            {
+                return false;
+            }
+
+            framebuffer->memory = memory;
+            break;
+        }
+    }
+
+    framebuffer->capacity = capacity;
+    return true;
+}
+
+static void release_framebuffer_memory(UnixFramebuffer* framebuffer)
+{
+    if (framebuffer->memory != NULL)
+    {
+        switch (framebuffer->storage)
+        {
+            case UNIX_FRAMEBUFFER_HEAP:
+            {
+                free(framebuffer->memory);
+                break;
+            }
+            case UNIX_FRAMEBUFFER_SYSV_SHM:
+            {
+                shmdt(framebuffer->memory);
+                break;
+            }
+            case UNIX_FRAMEBUFFER_MEMFD:
+            {
+                munmap(framebuffer->memory, framebuffer->capacity);
+                break;
+            }
+        }
+    }
+
+    framebuffer->memory = NULL;
+    framebuffer->capacity = 0;
+    framebuffer->shmId = -1;
+}
@@ -0,0 +1,90 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  framebuffer_unix.h
+** Module       :  framebuffer
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-18 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix framebuffers, in process memory or shared
+**                 with the display server.
+**
+***************************************************************/
+
+#ifndef FRAMEBUFFER_UNIX_H
+#define FRAMEBUFFER_UNIX_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "framebuffer.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+#ifdef __unix
+
+    typedef enum
+    {
+        UNIX_FRAMEBUFFER_HEAP,
+
+        /* a System V segment, for MIT-SHM */
+        UNIX_FRAMEBUFFER_SYSV_SHM,
+
+        /* a memfd, for wl_shm pools */
+        UNIX_FRAMEBUFFER_MEMFD
+    } UnixFramebufferStorage;
+
+    typedef struct
+    {
+        UnixFramebufferStorage storage;
+
+        /* frameCount frames packed one after another */
+        uint8_t* memory;
+        size_t capacity;
+        int frameCount;
+
+        int width;
+        int height;
+        size_t stride;
+        size_t frameSize;
+
+        /* bumped whenever memory moves, so whoever shared the old block can share the new one */
+        uint32_t generation;
+
+        /* -1 for storage that doesn't use them */
+        int shmId;
+        int fd;
+    } UnixFramebuffer;
+
+#endif
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+#ifdef __unix
+
+    void init_unix_framebuffer(UnixFramebuffer* framebuffer, UnixFramebufferStorage storage, int frameCount);
+
+    /* only allocates when the frames no longer fit, the contents are undefined afterwards */
+    bool resize_unix_framebuffer(UnixFramebuffer* framebuffer, int width, int height);
+
+    uint8_t* get_unix_framebuffer_frame(UnixFramebuffer* framebuffer, int index);
+
+    void destroy_unix_framebuffer(UnixFramebuffer* framebuffer);
+
+#endif
+
+#endif /* FRAMEBUFFER_UNIX_H */
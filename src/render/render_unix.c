@@ -0,0 +1,373 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  render_unix.c
+** Module       :  render
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-14 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix render thread. The thread owns every GL
+**                 context and is fed input, resize and damage by
+**                 the event thread through a lock-free queue, so a
+**                 slow frame never delays event handling.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "render_unix.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define RENDER_QUEUE_CAPACITY 1024
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static void* run_render_thread(void* data);
+static bool apply_render_message(UnixApp* app, UnixRenderMessage* message);
+static void add_render_window(UnixRenderThread* renderThread, UnixWindow* window);
+static void remove_render_window(UnixRenderThread* renderThread, UnixWindow* window);
+static void release_current_context(UnixApp* app);
+static void signal_fd(int fd);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+bool start_render_thread(UnixApp* app)
+{
+    UnixRenderThread* renderThread = calloc(1, sizeof(UnixRenderThread));
+    renderThread->wakeFd = eventfd(0, EFD_CLOEXEC);
+    renderThread->retireFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    struct epoll_event retireEvent = { .events = EPOLLIN, .data.u32 = UNIX_APP_SOURCE_RENDER_THREAD };
+
+    if (renderThread->wakeFd < 0 || renderThread->retireFd < 0 ||
+        !create_spsc_queue(&renderThread->messages, RENDER_QUEUE_CAPACITY, sizeof(UnixRenderMessage)) ||
+        epoll_ctl(app->epollFd, EPOLL_CTL_ADD, renderThread->retireFd, &retireEvent) < 0)
+    {
+        log_error("Failed to set up the render thread");
+        destroy_spsc_queue(&renderThread->messages);
+        close(renderThread->wakeFd);
+        close(renderThread->retireFd);
+        free(renderThread);
+        return false;
+    }
+
+    /* everything created so far belongs to the render thread from here on */
+    for (size_t i = 0; i < app->registry.count; i++)
+    {
+        add_render_window(renderThread, app->registry.windows[i]);
+    }
+
+    release_current_context(app);
+
+    app->renderThread = renderThread;
+
+    if (pthread_create(&renderThread->thread, NULL, run_render_thread, app) != 0)
+    {
+        log_error("Failed to start the render thread");
+        app->renderThread = NULL;
+        epoll_ctl(app->epollFd, EPOLL_CTL_DEL, renderThread->retireFd, NULL);
+        destroy_spsc_queue(&renderThread->messages);
+        close(renderThread->wakeFd);
+        close(renderThread->retireFd);
+        free(renderThread->windows);
+        free(renderThread);
+        return false;
+    }
+
+    log_info("Render thread started");
+
+    return true;
+}
+
+void stop_render_thread(UnixApp* app)
+{
+    UnixRenderThread* renderThread = app->renderThread;
+
+    if (renderThread == NULL)
+    {
+        return;
+    }
+
+    post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_STOP });
+    flush_render_messages(app);
+    pthread_join(renderThread->thread, NULL);
+
+    collect_retired_windows(app);
+
+    /* windows still alive go back to being rendered on this thread */
+    app->renderThread = NULL;
+
+    epoll_ctl(app->epollFd, EPOLL_CTL_DEL, renderThread->retireFd, NULL);
+    destroy_spsc_queue(&renderThread->messages);
+    close(renderThread->wakeFd);
+    close(renderThread->retireFd);
+    free(renderThread->windows);
+    free(renderThread);
+
+    log_info("Render thread stopped");
+}
+
+void post_render_message(UnixApp* app, UnixRenderMessage message)
+{
+    UnixRenderThread* renderThread = app->renderThread;
+
+    while (!spsc_queue_push(&renderThread->messages, &message))
+    {
+        /* the render thread is behind, make sure it is awake and let it catch up */
+        signal_fd(renderThread->wakeFd);
+        sched_yield();
+    }
+
+    renderThread->hasUnflushedMessages = true;
+}
+
+void flush_render_messages(UnixApp* app)
+{
+    UnixRenderThread* renderThread = app->renderThread;
+
+    /* one wakeup per dispatch pass rather than one per message */
+    if (renderThread != NULL && renderThread->hasUnflushedMessages)
+    {
+        renderThread->hasUnflushedMessages = false;
+        signal_fd(renderThread->wakeFd);
+    }
+}
+
+void collect_retired_windows(UnixApp* app)
+{
+    UnixRenderThread* renderThread = app->renderThread;
+
+    if (renderThread == NULL)
+    {
+        return;
+    }
+
+    uint64_t count;
+    while (read(renderThread->retireFd, &count, sizeof(count)) < 0 && errno == EINTR)
+    {
+    }
+
+    UnixWindow* window = atomic_exchange(&renderThread->retiredWindows, NULL);
+    while (window != NULL)
+    {
+        UnixWindow* next = window->nextRetired;
+        destroy_unix_window(app, window);
+        window = next;
+    }
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static void* run_render_thread(void* data)
+{
+    UnixApp* app = (UnixApp*)data;
+    UnixRenderThread* renderThread = app->renderThread;
+
+    bool isRunning = true;
+
+    while (isRunning)
+    {
+        UnixRenderMessage message;
+        while (spsc_queue_pop(&renderThread->messages, &message))
+        {
+            isRunning &= apply_render_message(app, &message);
+        }
+
+        for (size_t i = 0; i < renderThread->windowCount; i++)
+        {
+            render_unix_window(app, renderThread->windows[i]);
+        }
+
+        /* swaps and flushes may have read events off the socket, which epoll can no longer see */
+        if (app->appType == UNIX_APP_XORG && renderThread->windowCount > 0)
+        {
+            Display* display = app->data.xorgData.display;
+
+            XLockDisplay(display);
+            bool hasQueuedEvents = XQLength(display) > 0;
+            XUnlockDisplay(display);
+
+            if (hasQueuedEvents)
+            {
+                signal_fd(renderThread->retireFd);
+            }
+        }
+
+        if (!isRunning)
+        {
+            break;
+        }
+
+        /* anything posted while we rendered has already bumped the counter, so this can't miss a wakeup */
+        uint64_t count;
+        while (read(renderThread->wakeFd, &count, sizeof(count)) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    release_current_context(app);
+
+    return NULL;
+}
+
+static bool apply_render_message(UnixApp* app, UnixRenderMessage* message)
+{
+    UnixRenderThread* renderThread = app->renderThread;
+
+    switch (message->type)
+    {
+        case UNIX_RENDER_MESSAGE_ADD_WINDOW:
+        {
+            add_render_window(renderThread, message->window);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_REMOVE_WINDOW:
+        {
+            UnixWindow* window = message->window;
+
+            /* a window that failed during creation may never have been added */
+            remove_render_window(renderThread, window);
+            release_window_gl(app, window);
+            window->isRetired = true;
+
+            window->nextRetired = atomic_load(&renderThread->retiredWindows);
+            while (!atomic_compare_exchange_weak(&renderThread->retiredWindows, &window->nextRetired, window))
+            {
+            }
+
+            signal_fd(renderThread->retireFd);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_INVALIDATE:
+        {
+            apply_window_damage(message->window, (WindowRect) { 0, 0, message->window->width, message->window->height });
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_INVALIDATE_RECT:
+        {
+            apply_window_damage(message->window, message->data.rect);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_RESIZE:
+        {
+            apply_window_resize(message->window, message->data.size.width, message->data.size.height);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_SWAP_INTERVAL:
+        {
+            apply_swap_interval(message->window, message->data.swapInterval);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_FRAMES_IN_FLIGHT:
+        {
+            apply_max_frames_in_flight(message->window, message->data.framesInFlight);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_IMAGE_RELEASE:
+        {
+            apply_image_release(message->window, message->data.shmSegment);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_BUFFER_RELEASE:
+        {
+            apply_buffer_release(message->window, message->data.buffer);
+            break;
+        }
+        case UNIX_RENDER_MESSAGE_STOP:
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void add_render_window(UnixRenderThread* renderThread, UnixWindow* window)
+{
+    if (renderThread->windowCount == renderThread->windowCapacity)
+    {
+        size_t capacity = renderThread->windowCapacity == 0 ? 8 : renderThread->windowCapacity * 2;
+        UnixWindow** windows = realloc(renderThread->windows, capacity * sizeof(UnixWindow*));
+        if (windows == NULL)
+        {
+            log_error("Failed to add a window to the render thread");
+            return;
+        }
+
+        renderThread->windows = windows;
+        renderThread->windowCapacity = capacity;
+    }
+
+    renderThread->windows[renderThread->windowCount++] = window;
+}
+
+static void remove_render_window(UnixRenderThread* renderThread, UnixWindow* window)
+{
+    for (size_t i = 0; i < renderThread->windowCount; i++)
+    {
+        if (renderThread->windows[i] == window)
+        {
+            renderThread->windows[i] = renderThread->windows[--renderThread->windowCount];
+            return;
+        }
+    }
+}
+
+static void release_current_context(UnixApp* app)
+{
+    if (app->currentContext == 0)
+    {
+        return;
+    }
+
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(app->egl.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    else if (app->appType == UNIX_APP_XORG)
+    {
+        glXMakeCurrent(app->data.xorgData.display, None, NULL);
+    }
+
+    app->currentDrawable = 0;
+    app->currentContext = 0;
+}
+
+static void signal_fd(int fd)
+{
+    uint64_t value = 1;
+    while (write(fd, &value, sizeof(value)) < 0 && errno == EINTR)
+    {
+    }
+}
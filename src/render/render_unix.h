@@ -0,0 +1,129 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  render_unix.h
+** Module       :  render
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-14 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  The Angelo render thread for Unix systems
+**
+***************************************************************/
+
+#ifndef RENDER_UNIX_H
+#define RENDER_UNIX_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "../util/util.h"
+#include "../util/spsc_queue.h"
+#include "../app/app_unix.h"
+#include "../win/win_unix.h"
+
+#ifdef __unix
+
+    #include <pthread.h>
+
+#endif
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+#ifdef __unix
+
+    typedef enum
+    {
+        UNIX_RENDER_MESSAGE_ADD_WINDOW,
+        UNIX_RENDER_MESSAGE_REMOVE_WINDOW,
+        UNIX_RENDER_MESSAGE_INVALIDATE,
+        UNIX_RENDER_MESSAGE_INVALIDATE_RECT,
+        UNIX_RENDER_MESSAGE_RESIZE,
+        UNIX_RENDER_MESSAGE_SWAP_INTERVAL,
+        UNIX_RENDER_MESSAGE_FRAMES_IN_FLIGHT,
+        UNIX_RENDER_MESSAGE_IMAGE_RELEASE,
+        UNIX_RENDER_MESSAGE_BUFFER_RELEASE,
+        UNIX_RENDER_MESSAGE_STOP
+    } UnixRenderMessageType;
+
+    typedef struct
+    {
+        UnixRenderMessageType type;
+        UnixWindow* window;
+
+        union
+        {
+            WindowRect rect;
+
+            struct
+            {
+                int width;
+                int height;
+            } size;
+
+            int swapInterval;
+            int framesInFlight;
+            ShmSeg shmSegment;
+            struct wl_buffer* buffer;
+        } data;
+    } UnixRenderMessage;
+
+    typedef struct UnixRenderThread
+    {
+        pthread_t thread;
+
+        /* event thread to render thread */
+        SpscQueue messages;
+
+        /* render thread to event thread, stack of windows whose gl resources are released */
+        _Atomic(UnixWindow*) retiredWindows;
+
+        /* eventfd the render thread sleeps on */
+        int wakeFd;
+
+        /* eventfd in the app's epoll set, signalled when windows are retired or events were left in Xlib's queue */
+        int retireFd;
+
+        /* set when messages were pushed since the last wakeup */
+        bool hasUnflushedMessages;
+
+        /* windows the render thread draws, only touched by the render thread */
+        UnixWindow** windows;
+        size_t windowCount;
+        size_t windowCapacity;
+    } UnixRenderThread;
+
+#endif
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+#ifdef __unix
+
+    /* hands every context and all registered windows over to a new render thread */
+    bool start_render_thread(UnixApp* app);
+
+    /* renders whatever is still pending, joins the thread and retires its windows */
+    void stop_render_thread(UnixApp* app);
+
+    /* event thread only, wakeups are deferred to flush_render_messages */
+    void post_render_message(UnixApp* app, UnixRenderMessage message);
+    void flush_render_messages(UnixApp* app);
+
+    /* finishes destroying windows the render thread has let go of */
+    void collect_retired_windows(UnixApp* app);
+
+#endif
+
+#endif /* RENDER_UNIX_H */
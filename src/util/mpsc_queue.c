@@ -0,0 +1,103 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  mpsc_queue.c
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-17 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free multiple producer, single consumer
+**                 intrusive queue (after Dmitry Vyukov's design).
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "mpsc_queue.h"
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+void create_mpsc_queue(MpscQueue* queue)
+{
+    atomic_init(&queue->stub.next, NULL);
+    atomic_init(&queue->head, &queue->stub);
+    queue->tail = &queue->stub;
+}
+
+void mpsc_queue_push(MpscQueue* queue, MpscNode* node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+
+    /* claim the head, then link the previous node to us */
+    MpscNode* previous = atomic_exchange_explicit(&queue->head, node, memory_order_acq_rel);
+    atomic_store_explicit(&previous->next, node, memory_order_release);
+}
+
+MpscNode* mpsc_queue_pop(MpscQueue* queue)
+{
+    MpscNode* tail = queue->tail;
+    MpscNode* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &queue->stub)
+    {
+        if (next == NULL)
+        {
+            return NULL;
+        }
+
+        /* step over the stub */
+        queue->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (next != NULL)
+    {
+        queue->tail = next;
+        return tail;
+    }
+
+    /* tail looks like the last node, but a producer may have claimed the head after it */
+    if (tail != atomic_load_explicit(&queue->head, memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    /* put the stub back behind the last node so it can be handed out */
+    mpsc_queue_push(queue, &queue->stub);
+
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL)
+    {
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
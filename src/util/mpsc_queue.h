@@ -0,0 +1,72 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  mpsc_queue.h
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-17 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free multiple producer, single consumer
+**                 intrusive queue.
+**
+***************************************************************/
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define MPSC_QUEUE_CACHE_LINE 64
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/* embedded in whatever is queued */
+typedef struct MpscNode
+{
+    _Atomic(struct MpscNode*) next;
+} MpscNode;
+
+typedef struct
+{
+    /* newest node, swapped by producers */
+    _Alignas(MPSC_QUEUE_CACHE_LINE) _Atomic(MpscNode*) head;
+
+    /* oldest node, only touched by the consumer */
+    _Alignas(MPSC_QUEUE_CACHE_LINE) MpscNode* tail;
+
+    /* placeholder that keeps the list non-empty */
+    MpscNode stub;
+} MpscQueue;
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+void create_mpsc_queue(MpscQueue* queue);
+
+/* any thread, wait-free */
+void mpsc_queue_push(MpscQueue* queue, MpscNode* node);
+
+/* 
+** consumer only. returns NULL when the queue is empty, or while a producer
+** is between its two steps, in which case that producer's push is still
+** in flight and the node shows up on a later pop.
+*/
+MpscNode* mpsc_queue_pop(MpscQueue* queue);
+
+#endif /* MPSC_QUEUE_H */
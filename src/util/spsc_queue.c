@@ -0,0 +1,112 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  spsc_queue.c
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-14 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free single producer, single consumer 
+**                 queue of fixed size elements.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "spsc_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+bool create_spsc_queue(SpscQueue* queue, size_t capacity, size_t elementSize)
+{
+    size_t roundedCapacity = 1;
+    while (roundedCapacity < capacity)
+    {
+        roundedCapacity <<= 1;
+    }
+
+    queue->buffer = malloc(roundedCapacity * elementSize);
+    if (queue->buffer == NULL)
+    {
+        return false;
+    }
+
+    queue->capacity = roundedCapacity;
+    queue->elementSize = elementSize;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+
+    return true;
+}
+
+void destroy_spsc_queue(SpscQueue* queue)
+{
+    free(queue->buffer);
+    queue->buffer = NULL;
+    queue->capacity = 0;
+}
+
+bool spsc_queue_push(SpscQueue* queue, const void* element)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail - head == queue->capacity)
+    {
+        return false;
+    }
+
+    memcpy(queue->buffer + (tail & (queue->capacity - 1)) * queue->elementSize, element, queue->elementSize);
+
+    /* publish the element to the consumer */
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+bool spsc_queue_pop(SpscQueue* queue, void* element)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return false;
+    }
+
+    memcpy(element, queue->buffer + (head & (queue->capacity - 1)) * queue->elementSize, queue->elementSize);
+
+    /* hand the slot back to the producer */
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
@@ -0,0 +1,65 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  spsc_queue.h
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-14 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free single producer, single consumer 
+**                 queue of fixed size elements.
+**
+***************************************************************/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define SPSC_QUEUE_CACHE_LINE 64
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+typedef struct
+{
+    /* written only by the consumer */
+    _Alignas(SPSC_QUEUE_CACHE_LINE) atomic_size_t head;
+
+    /* written only by the producer */
+    _Alignas(SPSC_QUEUE_CACHE_LINE) atomic_size_t tail;
+
+    _Alignas(SPSC_QUEUE_CACHE_LINE) uint8_t* buffer;
+    size_t capacity;
+    size_t elementSize;
+} SpscQueue;
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+/* capacity is rounded up to a power of two */
+bool create_spsc_queue(SpscQueue* queue, size_t capacity, size_t elementSize);
+void destroy_spsc_queue(SpscQueue* queue);
+
+/* producer side, returns false when the queue is full */
+bool spsc_queue_push(SpscQueue* queue, const void* element);
+
+/* consumer side, returns false when the queue is empty */
+bool spsc_queue_pop(SpscQueue* queue, void* element);
+
+#endif /* SPSC_QUEUE_H */
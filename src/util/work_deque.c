@@ -0,0 +1,133 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  work_deque.c
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-20 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free, fixed capacity work stealing deque
+**                 (the Chase-Lev deque with the C11 orderings from
+**                 Le, Pop, Cohen and Zappa Nardelli).
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "work_deque.h"
+
+#include <stdlib.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+bool create_work_deque(WorkDeque* deque, size_t capacity)
+{
+    size_t roundedCapacity = 1;
+    while (roundedCapacity < capacity)
+    {
+        roundedCapacity <<= 1;
+    }
+
+    deque->items = malloc(roundedCapacity * sizeof(_Atomic(uint32_t)));
+    if (deque->items == NULL)
+    {
+        return false;
+    }
+
+    deque->mask = (long long)roundedCapacity - 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+
+    return true;
+}
+
+void destroy_work_deque(WorkDeque* deque)
+{
+    free(deque->items);
+    deque->items = NULL;
+    deque->mask = 0;
+}
+
+bool work_deque_push(WorkDeque* deque, uint32_t item)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if (bottom - top > deque->mask)
+    {
+        return false;
+    }
+
+    atomic_store_explicit(&deque->items[bottom & deque->mask], item, memory_order_relaxed);
+
+    /* the item, and whatever the owner wrote before pushing it, is visible to a thief that sees the new bottom */
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+
+    return true;
+}
+
+bool work_deque_pop(WorkDeque* deque, uint32_t* item)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+
+    /* publish the claim on the newest item before looking at what thieves have taken */
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *item = atomic_load_explicit(&deque->items[bottom & deque->mask], memory_order_relaxed);
+
+    if (top == bottom)
+    {
+        /* the last item, race the thieves for it */
+        bool isWon = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return isWon;
+    }
+
+    return true;
+}
+
+bool work_deque_steal(WorkDeque* deque, uint32_t* item)
+{
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return false;
+    }
+
+    *item = atomic_load_explicit(&deque->items[top & deque->mask], memory_order_relaxed);
+
+    return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+}
@@ -0,0 +1,67 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  work_deque.h
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-20 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A lock-free, fixed capacity work stealing deque
+**                 of 32 bit work items.
+**
+***************************************************************/
+
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define WORK_DEQUE_CACHE_LINE 64
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+typedef struct
+{
+    /* oldest item, advanced by thieves and by the owner taking the last item */
+    _Alignas(WORK_DEQUE_CACHE_LINE) atomic_llong top;
+
+    /* one past the newest item, written only by the owner */
+    _Alignas(WORK_DEQUE_CACHE_LINE) atomic_llong bottom;
+
+    _Alignas(WORK_DEQUE_CACHE_LINE) _Atomic(uint32_t)* items;
+    long long mask;
+} WorkDeque;
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+/* capacity is rounded up to a power of two */
+bool create_work_deque(WorkDeque* deque, size_t capacity);
+void destroy_work_deque(WorkDeque* deque);
+
+/* owner only, returns false when the deque is full */
+bool work_deque_push(WorkDeque* deque, uint32_t item);
+
+/* owner only, newest item first. returns false when the deque is empty */
+bool work_deque_pop(WorkDeque* deque, uint32_t* item);
+
+/* any thread, oldest item first. returns false when the deque is empty or another thread won the item */
+bool work_deque_steal(WorkDeque* deque, uint32_t* item);
+
+#endif /* WORK_DEQUE_H */
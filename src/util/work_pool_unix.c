@@ -0,0 +1,330 @@
+/***************************************************************
+**
+** Angelo Library Source File
+**
+** File         :  work_pool_unix.c
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-20 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  Unix work pool. Every thread pops its own deque
+**                 newest first and steals from the others oldest
+**                 first, so nested work stays local until another
+**                 thread runs dry. Locks are only taken to start a
+**                 run and to put idle threads to sleep, both between
+**                 runs and once a thread has spun dry during one.
+**
+***************************************************************/
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include "work_pool_unix.h"
+
+#include "../debug/debug.h"
+
+#include <stdlib.h>
+#include <sched.h>
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+#define WORK_DEQUE_CAPACITY 4096
+#define WORK_SPIN_LIMIT 64
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+/***************************************************************
+** MARK: STATIC VARIABLES
+***************************************************************/
+
+/* which deque push_work goes to on this thread */
+static _Thread_local uint32_t currentWorker;
+
+/***************************************************************
+** MARK: STATIC FUNCTION DEFS
+***************************************************************/
+
+static void* run_worker(void* data);
+static void do_work(WorkPool* pool, uint32_t index);
+static bool find_work(WorkPool* pool, uint32_t index, uint32_t* item);
+static void finish_work(WorkPool* pool);
+static void signal_work(WorkPool* pool);
+static void park_worker(WorkPool* pool, uint32_t index);
+
+/***************************************************************
+** MARK: PUBLIC FUNCTIONS
+***************************************************************/
+
+WorkPool* create_work_pool(uint32_t threadCount)
+{
+    WorkPool* pool = calloc(1, sizeof(WorkPool));
+    if (pool == NULL)
+    {
+        log_error("Failed to allocate a work pool");
+        return NULL;
+    }
+
+    threadCount = threadCount > 0 ? threadCount : 1;
+
+    pool->deques = calloc(threadCount, sizeof(WorkDeque));
+    pool->workers = calloc(threadCount, sizeof(WorkPoolWorker));
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->workEpoch, 0);
+    atomic_init(&pool->idleCount, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    if (pool->deques == NULL || pool->workers == NULL)
+    {
+        log_error("Failed to allocate a work pool");
+        destroy_work_pool(pool);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        if (!create_work_deque(&pool->deques[i], WORK_DEQUE_CAPACITY))
+        {
+            log_error("Failed to allocate a work pool");
+            destroy_work_pool(pool);
+            return NULL;
+        }
+
+        pool->workers[i] = (WorkPoolWorker) { .pool = pool, .index = i };
+        pool->dequeCount = i + 1;
+    }
+
+    pool->threadCount = 1;
+
+    /* the first deque belongs to whoever calls run_work_pool */
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        if (pthread_create(&pool->workers[i].thread, NULL, run_worker, &pool->workers[i]) != 0)
+        {
+            /* runs only use the threads that started, and only those are joined */
+            log_warn("Started %u of %u work pool threads", i, threadCount);
+            break;
+        }
+
+        pool->threadCount = i + 1;
+    }
+
+    return pool;
+}
+
+void destroy_work_pool(WorkPool* pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->isStopping = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 1; i < pool->threadCount; i++)
+    {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    for (uint32_t i = 0; i < pool->dequeCount; i++)
+    {
+        destroy_work_deque(&pool->deques[i]);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
+
+void run_work_pool(WorkPool* pool, WorkFunction function, void* context, const uint32_t* items, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    currentWorker = 0;
+    pool->function = function;
+    pool->context = context;
+    atomic_store_explicit(&pool->pending, count, memory_order_relaxed);
+
+    uint32_t pushed = 0;
+    while (pushed < count && work_deque_push(&pool->deques[0], items[pushed]))
+    {
+        pushed++;
+    }
+
+    if (pool->threadCount > 1)
+    {
+        pthread_mutex_lock(&pool->lock);
+        pool->runIndex++;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    /* whatever didn't fit runs here while the others steal */
+    for (uint32_t i = pushed; i < count; i++)
+    {
+        function(context, items[i]);
+        finish_work(pool);
+    }
+
+    do_work(pool, 0);
+}
+
+bool push_work(WorkPool* pool, uint32_t item)
+{
+    /* counted first, so the run can't look finished before the item is taken */
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+
+    if (!work_deque_push(&pool->deques[currentWorker], item))
+    {
+        atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed);
+        return false;
+    }
+
+    signal_work(pool);
+
+    return true;
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static void* run_worker(void* data)
+{
+    WorkPoolWorker* worker = (WorkPoolWorker*)data;
+    WorkPool* pool = worker->pool;
+    uint64_t seenRunIndex = 0;
+
+    currentWorker = worker->index;
+
+    while (true)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->isStopping && pool->runIndex == seenRunIndex)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+
+        bool isStopping = pool->isStopping;
+        seenRunIndex = pool->runIndex;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (isStopping)
+        {
+            return NULL;
+        }
+
+        do_work(pool, worker->index);
+    }
+}
+
+static void do_work(WorkPool* pool, uint32_t index)
+{
+    uint32_t spinCount = 0;
+
+    while (atomic_load_explicit(&pool->pending, memory_order_acquire) != 0)
+    {
+        uint32_t item;
+        if (find_work(pool, index, &item))
+        {
+            pool->function(pool->context, item);
+            finish_work(pool);
+            spinCount = 0;
+        }
+        else if (spinCount < WORK_SPIN_LIMIT)
+        {
+            sched_yield();
+            spinCount++;
+        }
+        else
+        {
+            park_worker(pool, index);
+            spinCount = 0;
+        }
+    }
+}
+
+static bool find_work(WorkPool* pool, uint32_t index, uint32_t* item)
+{
+    if (work_deque_pop(&pool->deques[index], item))
+    {
+        return true;
+    }
+
+    /* start with the next thread along so thieves spread out */
+    for (uint32_t i = 1; i < pool->threadCount; i++)
+    {
+        if (work_deque_steal(&pool->deques[(index + i) % pool->threadCount], item))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void finish_work(WorkPool* pool)
+{
+    /* releases everything the item wrote to whoever sees the run finish */
+    if (atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release) == 1)
+    {
+        signal_work(pool);
+    }
+}
+
+static void signal_work(WorkPool* pool)
+{
+    /*
+    ** seq_cst on both sides: either the parking thread sees the new epoch,
+    ** or we see it counted as idle and take the lock it waits under
+    */
+    atomic_fetch_add(&pool->workEpoch, 1);
+
+    if (atomic_load(&pool->idleCount) > 0)
+    {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void park_worker(WorkPool* pool, uint32_t index)
+{
+    uint32_t epoch = atomic_load(&pool->workEpoch);
+
+    /* anything pushed before the epoch was read is in a deque by now */
+    uint32_t item;
+    if (find_work(pool, index, &item))
+    {
+        pool->function(pool->context, item);
+        finish_work(pool);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->idleCount, 1);
+
+    while (atomic_load(&pool->workEpoch) == epoch && atomic_load_explicit(&pool->pending, memory_order_acquire) != 0)
+    {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+
+    atomic_fetch_sub(&pool->idleCount, 1);
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,108 @@
+/***************************************************************
+**
+** Angelo Library Header File
+**
+** File         :  work_pool_unix.h
+** Module       :  util
+** Project      :  Angelo
+** Author       :  SH
+** Created      :  2025-02-20 (YYYY-MM-DD)
+** License      :  MIT
+** Description  :  A fork-join pool of work stealing threads for
+**                 Unix systems
+**
+***************************************************************/
+
+#ifndef WORK_POOL_UNIX_H
+#define WORK_POOL_UNIX_H
+
+/***************************************************************
+** MARK: INCLUDES
+***************************************************************/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "work_deque.h"
+
+#ifdef __unix
+
+    #include <pthread.h>
+
+#endif
+
+/***************************************************************
+** MARK: CONSTANTS & MACROS
+***************************************************************/
+
+/***************************************************************
+** MARK: TYPEDEFS
+***************************************************************/
+
+#ifdef __unix
+
+    typedef void (*WorkFunction)(void* context, uint32_t item);
+
+    typedef struct WorkPool WorkPool;
+
+    typedef struct
+    {
+        WorkPool* pool;
+        uint32_t index;
+        pthread_t thread;
+    } WorkPoolWorker;
+
+    struct WorkPool
+    {
+        /* one deque per thread, the thread calling run_work_pool owns the first */
+        WorkDeque* deques;
+        uint32_t dequeCount;
+
+        /* threads taking part in runs, the calling thread included. the first threadCount deques are in use */
+        WorkPoolWorker* workers;
+        uint32_t threadCount;
+
+        /* the run in progress */
+        WorkFunction function;
+        void* context;
+
+        /* items pushed but not finished yet, the run is over when it reaches 0 */
+        _Alignas(WORK_DEQUE_CACHE_LINE) atomic_uint pending;
+
+        /* bumped when work is pushed or the run ends. threads that spun dry park on idle until it moves */
+        atomic_uint workEpoch;
+        atomic_uint idleCount;
+        pthread_cond_t idle;
+
+        /* workers sleep here between runs */
+        pthread_mutex_t lock;
+        pthread_cond_t wake;
+        uint64_t runIndex;
+        bool isStopping;
+    };
+
+#endif
+
+/***************************************************************
+** MARK: FUNCTION DEFS
+***************************************************************/
+
+#ifdef __unix
+
+    /* threadCount includes the thread that calls run_work_pool, so 1 starts no threads */
+    WorkPool* create_work_pool(uint32_t threadCount);
+    void destroy_work_pool(WorkPool* pool);
+
+    /*
+    ** calls function for every item, and for every item pushed while it
+    ** runs, spread over the pool's threads. the calling thread helps and
+    ** returns once all of them are done. one run at a time per pool.
+    */
+    void run_work_pool(WorkPool* pool, WorkFunction function, void* context, const uint32_t* items, uint32_t count);
+
+    /* from inside a work function only. false when the thread's deque is full, run the item inline then */
+    bool push_work(WorkPool* pool, uint32_t item);
+
+#endif
+
+#endif /* WORK_POOL_UNIX_H */
@@ -23,6 +23,7 @@
 ***************************************************************/
 
 #include <stdint.h>
+#include <stddef.h>
 #include "../util/util.h"
 #include "../app/app.h"
 
@@ -37,6 +38,36 @@
 typedef uintptr_t WindowHandle;
 typedef OPTION(WindowHandle) WindowHandle_opt;
 
+/* a rectangle in window pixels, origin at the top left */
+typedef struct
+{
+    int x;
+    int y;
+    int width;
+    int height;
+} WindowRect;
+
+/* display timing of a window's frames, times are CLOCK_MONOTONIC nanoseconds */
+typedef struct
+{
+    /* when the last frame reached the screen */
+    uint64_t lastPresentTime;
+
+    /* the first vertical blank still ahead */
+    uint64_t nextVblankTime;
+
+    uint64_t refreshPeriod;
+
+    /* frames shown later than the first vertical blank they could have made */
+    uint32_t missedFrames;
+
+    /* how long the last swap blocked waiting for the gpu to catch up */
+    uint64_t cpuWaitTime;
+
+    /* false when the times are estimated from submission rather than reported by the display */
+    bool isPrecise;
+} WindowFrameTiming;
+
 /***************************************************************
 ** MARK: FUNCTION DEFS
 ***************************************************************/
@@ -45,4 +76,59 @@ WindowHandle_opt create_window(AppHandle app, int width, int height, const char*
 void clear_window(AppHandle app, WindowHandle handle);
 void swap_window_buffers(AppHandle app, WindowHandle handle);
 
+/*
+** like swap_window_buffers, but only rects (window coordinates, top-left
+** origin) changed since the last frame, so the compositor copies less.
+** a count of 0 damages the whole window.
+*/
+void swap_window_buffers_with_damage(AppHandle app, WindowHandle handle, const WindowRect* rects, int count);
+
+/*
+** how many frames ago the back buffer was drawn, so only what changed since
+** then needs drawing again. 0 means its contents are undefined.
+*/
+int get_window_buffer_age(AppHandle app, WindowHandle handle);
+
+/* 
+** mark the window (or part of it) as needing a repaint. invalidations are
+** coalesced by the event loop, so any number of calls between two frames
+** produce a single redraw.
+*/
+void invalidate_window(AppHandle app, WindowHandle handle);
+void invalidate_rect(AppHandle app, WindowHandle handle, WindowRect rect);
+
+/*
+** timestamp in milliseconds of the last frame shown. on wayland this is the
+** compositor's frame callback time, elsewhere the time the frame was submitted.
+** use it as the clock for animations.
+*/
+uint32_t get_window_frame_time(AppHandle app, WindowHandle handle);
+
+/*
+** precise on X11 with GLX_OML_sync_control, estimated elsewhere. schedule
+** work against nextVblankTime to start a frame as late as possible.
+*/
+WindowFrameTiming get_window_frame_timing(AppHandle app, WindowHandle handle);
+
+/*
+** number of vertical blanks each swap waits for. 0 presents immediately,
+** -1 waits like 1 but lets a late frame through straight away (adaptive).
+** where the driver can't do it, frames are paced by sleeping instead.
+*/
+void set_swap_interval(AppHandle app, WindowHandle handle, int interval);
+
+/*
+** how many swapped frames the gpu may still be working on before the next
+** swap blocks. fewer means less input latency but less overlap, 0 disables
+** the limit. defaults to 2.
+*/
+void set_max_frames_in_flight(AppHandle app, WindowHandle handle, int count);
+
+/*
+** copy the last rendered frame into pixels as tightly packed RGBA8 rows,
+** top row first. size must hold at least width * height * 4 bytes.
+** only supported by the headless backend.
+*/
+bool read_window_pixels(AppHandle app, WindowHandle handle, uint8_t* pixels, size_t size);
+
 #endif /* WIN_H */
\ No newline at end of file
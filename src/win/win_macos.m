@@ -19,6 +19,7 @@
 #include "win.h"
 #include "../debug/debug.h"
 #include "../util/util.h"
+#include "../framebuffer/framebuffer.h"
 
 #include <simd/simd.h>
 #include <QuartzCore/CAMetalLayer.h>
@@ -104,10 +105,12 @@ id<MTLCommandQueue> metalCommandQueue;
 id<MTLRenderPipelineState> metalRenderPSO;
 id<MTLBuffer> triangleVertexBuffer;
 
-// Shared memory and Metal texture
+// Shared memory and Metal texture, kept across frames and only reallocated when a resize outgrows the buffer
 id<MTLTexture> sharedTexture;
 id<MTLBuffer> sharedBuffer;
 CGContextRef sharedContext;
+size_t sharedWidth = 0;
+size_t sharedHeight = 0;
 
 float mouseX = 0.0f;
 float mouseY = 0.0f;
@@ -118,8 +121,8 @@ int frameTimeUs = 0;
 ** MARK: STATIC FUNCTION DEFS
 ***************************************************************/
 
-void create_shared_texture(size_t textureWidth, size_t textureHeight);
-void destroy_shared_texture();
+void ensure_shared_texture(size_t textureWidth, size_t textureHeight);
+void draw_shared_texture(size_t textureWidth, size_t textureHeight);
 void render(size_t width, size_t height);
 
 /***************************************************************
@@ -299,23 +302,41 @@ WindowHandle_opt create_window(int width, int height, const char* title)
 @end
 
 
-void create_shared_texture(size_t textureWidth, size_t textureHeight)
+void ensure_shared_texture(size_t textureWidth, size_t textureHeight)
 {
-    // create a core graphics context
-    size_t bytesPerPixel = 4; // For BGRA8Unorm
-    size_t alignedBytesPerRow = ((textureWidth * bytesPerPixel + 15) / 16) * 16;
+    if (sharedTexture != nil && sharedWidth == textureWidth && sharedHeight == textureHeight)
+    {
+        return;
+    }
+
+    // rows of a texture made from a buffer have to meet the device's alignment
+    size_t alignment = [metalDevice minimumLinearTextureAlignmentForPixelFormat:MTLPixelFormatBGRA8Unorm];
+    size_t alignedBytesPerRow = ((textureWidth * FRAMEBUFFER_BYTES_PER_PIXEL + alignment - 1) / alignment) * alignment;
+    size_t required = alignedBytesPerRow * textureHeight;
+
+    // the buffer only grows, a smaller or equal size reuses it
+    size_t capacity = sharedBuffer != nil ? [sharedBuffer length] : 0;
+    if (required > capacity)
+    {
+        sharedBuffer = [metalDevice newBufferWithLength:grow_framebuffer_capacity(capacity, required) options:MTLResourceStorageModeShared];
+    }
+
+    // the context and texture are only views of the buffer, so recreating them allocates no pixels
+    if (sharedContext != NULL)
+    {
+        CGContextRelease(sharedContext);
+    }
 
     CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-    sharedContext = CGBitmapContextCreate(NULL, textureWidth, textureHeight, 8,
+    sharedContext = CGBitmapContextCreate([sharedBuffer contents], textureWidth, textureHeight, 8,
                                           alignedBytesPerRow, colorSpace,
                                           kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
     CGColorSpaceRelease(colorSpace);
 
-    void *sharedMemory = CGBitmapContextGetData(sharedContext);
-
-    sharedBuffer = [metalDevice newBufferWithBytesNoCopy:sharedMemory length:CGBitmapContextGetBytesPerRow(sharedContext)*CGBitmapContextGetHeight(sharedContext) options:MTLResourceStorageModeShared deallocator: nil];
+    // Flip coordinate system, once for the context's lifetime
+    CGContextTranslateCTM(sharedContext, 0, textureHeight);
+    CGContextScaleCTM(sharedContext, 1.0, -1.0);
 
-    // Create a shared texture
     MTLTextureDescriptor *textureDescriptor = [[MTLTextureDescriptor alloc] init];
     textureDescriptor.pixelFormat = MTLPixelFormatBGRA8Unorm;
     textureDescriptor.width = textureWidth;
@@ -323,8 +344,13 @@ void create_shared_texture(size_t textureWidth, size_t textureHeight)
     textureDescriptor.usage = MTLTextureUsageShaderRead;
     textureDescriptor.storageMode = MTLStorageModeShared;
 
-    sharedTexture = [sharedBuffer newTextureWithDescriptor:textureDescriptor offset:0 bytesPerRow:CGBitmapContextGetBytesPerRow(sharedContext)];
+    sharedTexture = [sharedBuffer newTextureWithDescriptor:textureDescriptor offset:0 bytesPerRow:alignedBytesPerRow];
+    sharedWidth = textureWidth;
+    sharedHeight = textureHeight;
+}
 
+void draw_shared_texture(size_t textureWidth, size_t textureHeight)
+{
     CGContextClearRect(sharedContext, CGRectMake(0, 0, textureWidth, textureHeight));
    // CGContextSetRGBFillColor(sharedContext, 1.0, 0.5, 0.0, 1.0);
    // CGContextFillRect(sharedContext, CGRectMake(10, 10, textureWidth - 20, textureHeight - 20));    
@@ -348,8 +374,6 @@ void create_shared_texture(size_t textureWidth, size_t textureHeight)
 
     // Draw the text
     CGContextSetTextMatrix(sharedContext, CGAffineTransformIdentity); // Reset text matrix
-    CGContextTranslateCTM(sharedContext, 0, textureHeight); // Flip coordinate system
-    CGContextScaleCTM(sharedContext, 1.0, -1.0);
 
     for (int i = 0; i < numX; i++) {
         for (int j = 0; j < numY; j++) {
@@ -389,12 +413,6 @@ void create_shared_texture(size_t textureWidth, size_t textureHeight)
 
 
 
-}
-void destroy_shared_texture()
-{
-    sharedTexture = nil;
-    sharedBuffer = nil;
-    CGContextRelease(sharedContext);
 }
 
 void render(size_t width, size_t height)
@@ -406,7 +424,8 @@ void render(size_t width, size_t height)
 
             start_timer();
 
-            create_shared_texture(width, height);
+            ensure_shared_texture(width, height);
+            draw_shared_texture(width, height);
             
             MTLRenderPassDescriptor *passDescriptor = [MTLRenderPassDescriptor renderPassDescriptor];
             passDescriptor.colorAttachments[0].texture = [drawable texture];
@@ -424,11 +443,6 @@ void render(size_t width, size_t height)
             [commandBuffer presentDrawable:drawable];
             [commandBuffer commit];
             [commandBuffer waitUntilCompleted];
-            
-            
-
-            
-            destroy_shared_texture();
 
             stop_timer();
             //log_info("Render time: %.3f ms", (float)get_elapsed_micros() / 1000.0f);
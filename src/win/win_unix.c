@@ -16,9 +16,14 @@
 ** MARK: INCLUDES
 ***************************************************************/
 
+/* fences are core in the 3.3 contexts we create */
+#define GL_GLEXT_PROTOTYPES
+
 #include "win.h"
 #include "win_unix.h"
 #include "../app/app_unix.h"
+#include "../render/render_unix.h"
+#include "../app/timer_unix.h"
 
 #include "../debug/debug.h"
 #include "../util/util.h"
@@ -26,11 +31,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <errno.h>
 
 /***************************************************************
 ** MARK: CONSTANTS & MACROS
 ***************************************************************/
 
+/* refresh period assumed when swaps are paced in software */
+#define SOFTWARE_REFRESH_NANOS 16666667ull
+#define DEFAULT_FRAMES_IN_FLIGHT 2
+#define FRAME_FENCE_TIMEOUT_NANOS 1000000000ull
+#define MAX_DAMAGE_RECTS 16
+#define READ_PIXELS_SWAP_CHUNK 256
+
 /***************************************************************
 ** MARK: TYPEDEFS
 ***************************************************************/
@@ -47,10 +61,76 @@ static int context_attribs[] = {
     None
 };
 
+static EGLint egl_context_attribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+};
+
+static void handle_xdg_surface_configure(void* data, struct xdg_surface* xdgSurface, uint32_t serial);
+static void handle_toplevel_configure(void* data, struct xdg_toplevel* toplevel, int32_t width, int32_t height, struct wl_array* states);
+static void handle_toplevel_close(void* data, struct xdg_toplevel* toplevel);
+static void handle_frame_done(void* data, struct wl_callback* callback, uint32_t time);
+static void handle_buffer_release(void* data, struct wl_buffer* buffer);
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+    .configure = handle_xdg_surface_configure
+};
+
+static const struct xdg_toplevel_listener toplevel_listener = {
+    .configure = handle_toplevel_configure,
+    .close = handle_toplevel_close
+};
+
+static const struct wl_callback_listener frame_listener = {
+    .done = handle_frame_done
+};
+
+static const struct wl_buffer_listener buffer_listener = {
+    .release = handle_buffer_release
+};
+
 /***************************************************************
 ** MARK: STATIC FUNCTION DEFS
 ***************************************************************/
 
+static WindowHandle_opt create_wayland_window(UnixApp* app, int width, int height, const char* title);
+static WindowHandle_opt create_headless_window(UnixApp* app, int width, int height, const char* title);
+static bool attach_window(UnixApp* app, uintptr_t key, UnixWindow* window);
+static void mark_window_dirty(UnixWindow* window);
+static void apply_xorg_swap_interval(UnixApp* app, UnixWindow* window);
+static void limit_swap_rate(UnixWindow* window);
+static void limit_frames_in_flight(UnixWindow* window);
+static void release_frame_fences(UnixWindow* window);
+static void record_oml_frame_timing(UnixApp* app, UnixWindow* window);
+static void record_estimated_frame_timing(UnixWindow* window, uint64_t presentTime, uint64_t refreshPeriod);
+static void publish_frame_timing(UnixWindow* window, WindowFrameTiming timing);
+static GLXContext acquire_xorg_context(UnixApp* app);
+static EGLContext acquire_egl_context(UnixApp* app);
+static bool create_egl_surface(UnixApp* app, UnixWindow* window, void* nativeWindow);
+static uint32_t get_monotonic_millis();
+static void present_egl_surface(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count);
+static void record_window_damage(UnixWindow* window, const WindowRect* rects, int count);
+static int query_buffer_age(UnixApp* app, UnixWindow* window);
+static WindowRect get_repaint_rect(UnixApp* app, UnixWindow* window, WindowRect damage);
+static void begin_window_repaint(UnixApp* app, UnixWindow* window, WindowRect rect);
+static void end_window_repaint(UnixApp* app, UnixWindow* window);
+static WindowRect unite_rects(WindowRect a, WindowRect b);
+static void clear_gl_buffers(UnixApp* app);
+static bool is_cpu_window(UnixApp* app, UnixWindow* window);
+static void fill_window_pixels(UnixWindow* window, uint8_t* pixels, size_t stride, uint32_t value);
+static bool ensure_xorg_images(UnixApp* app, UnixWindow* window);
+static bool create_xorg_image(UnixApp* app, UnixWindow* window, int index);
+static void destroy_xorg_images(UnixApp* app, UnixWindow* window);
+static void present_xorg_image(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count);
+static bool ensure_wayland_buffers(UnixApp* app, UnixWindow* window);
+static void destroy_wayland_buffers(UnixWindow* window);
+static bool retire_wayland_buffer(UnixWindow* window, UnixShmBuffer* buffer);
+static int find_wayland_first_frame(UnixWindow* window, size_t frameSize);
+static int find_wayland_back_buffer(UnixWindow* window);
+static void present_wayland_buffer(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count);
+
 /***************************************************************
 ** MARK: PUBLIC FUNCTIONS
 ***************************************************************/
@@ -88,39 +168,78 @@ WindowHandle_opt create_window(AppHandle app, int width, int height, const char*
         XStoreName(unixApp->data.xorgData.display, window, title);
         XMapWindow(unixApp->data.xorgData.display, window);
 
-        /* Create an OpenGL 3.3 context */
+        UnixWindow* unixWindow = calloc(1, sizeof(UnixWindow));
+        unixWindow->title = title;
+        unixWindow->app = unixApp;
+        unixWindow->appType = UNIX_APP_XORG;
+        unixWindow->swapInterval = 1;
+        unixWindow->maxFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+        unixWindow->width = width;
+        unixWindow->height = height;
+        unixWindow->configuredWidth = width;
+        unixWindow->configuredHeight = height;
+        unixWindow->needsRedraw = true;
+        unixWindow->damageRect = (WindowRect) { 0, 0, width, height };
+        unixWindow->eglSurface = EGL_NO_SURFACE;
+        unixWindow->eglContext = EGL_NO_CONTEXT;
+        unixWindow->data.xorgData.rawHandle = window;
+        unixWindow->data.xorgData.deleteMessage = deleteAtom;
+
+        /* Create an OpenGL 3.3 context, software windows make their images on first draw instead */
 
-        PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB = NULL;
-        glXCreateContextAttribsARB = (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB((const GLubyte *)"glXCreateContextAttribsARB");
+        if (unixApp->config.softwareRendering)
+        {
+            unixWindow->data.xorgData.gc = XCreateGC(unixApp->data.xorgData.display, window, 0, NULL);
 
-        if (!glXCreateContextAttribsARB) {
-            log_error("glXCreateContextAttribsARB not found");
-            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+            for (int i = 0; i < UNIX_XORG_IMAGE_COUNT; i++)
+            {
+                init_unix_framebuffer(&unixWindow->data.xorgData.framebuffers[i], unixApp->data.xorgData.hasShm ? UNIX_FRAMEBUFFER_SYSV_SHM : UNIX_FRAMEBUFFER_HEAP, 1);
+            }
         }
-
-        GLXContext context = glXCreateContextAttribsARB(unixApp->data.xorgData.display, unixApp->data.xorgData.bestFbc, NULL, True, context_attribs);
-        if (!context) {
-            log_error("Failed to create OpenGL context");
-            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        else if (unixApp->egl.display != EGL_NO_DISPLAY)
+        {
+            if (!create_egl_surface(unixApp, unixWindow, &unixWindow->data.xorgData.rawHandle))
+            {
+                destroy_unix_window(unixApp, unixWindow);
+                return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+            }
+        }
+        else
+        {
+            unixWindow->data.xorgData.glContext = acquire_xorg_context(unixApp);
+            if (!unixWindow->data.xorgData.glContext)
+            {
+                destroy_unix_window(unixApp, unixWindow);
+                return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+            }
         }
 
-        glXMakeCurrent(unixApp->data.xorgData.display, window, context);
-
-        log_info("Initialised OpenGL %s", glGetString(GL_VERSION));
+        /* the render thread owns the current context while it runs */
+        if (unixApp->renderThread == NULL && !unixApp->config.softwareRendering)
+        {
+            make_window_current(unixApp, unixWindow);
 
-        UnixWindow* unixWindow = malloc(sizeof(UnixWindow));
-        unixWindow->title = title;
-        unixWindow->appType = UNIX_APP_XORG;
-        unixWindow->data.xorgData.rawHandle = window;
-        unixWindow->data.xorgData.deleteMessage = deleteAtom;
-        unixWindow->data.xorgData.glContext = context;
+            log_info("Initialised OpenGL %s", glGetString(GL_VERSION));
+        }
 
         XFlush(unixApp->data.xorgData.display);
 
-        unixApp->windowHandle = (WindowHandle)unixWindow; 
+        if (!attach_window(unixApp, (uintptr_t)window, unixWindow))
+        {
+            destroy_unix_window(unixApp, unixWindow);
+            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
 
         return (WindowHandle_opt) { .value = (intptr_t)unixWindow, .is_some = true };
     }
+    else if (unixApp->appType == UNIX_APP_WAYLAND)
+    {
+        return create_wayland_window(unixApp, width, height, title);
+    }
+    else if (unixApp->appType == UNIX_APP_HEADLESS)
+    {
+        return create_headless_window(unixApp, width, height, title);
+    }
     else
     {
         log_error("Invalid app type");
@@ -143,13 +262,77 @@ void clear_window(AppHandle app, WindowHandle handle)
     
     if (unixApp->appType == UNIX_APP_XORG)
     {
-        glXMakeCurrent(unixApp->data.xorgData.display, unixWindow->data.xorgData.rawHandle, unixWindow->data.xorgData.glContext);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (unixApp->config.softwareRendering)
+        {
+            if (ensure_xorg_images(unixApp, unixWindow))
+            {
+                XImage* image = unixWindow->data.xorgData.images[unixWindow->data.xorgData.backImage];
+                fill_window_pixels(unixWindow, (uint8_t*)image->data, (size_t)image->bytes_per_line, (uint32_t)image->green_mask);
+            }
+            return;
+        }
+
+        make_window_current(unixApp, unixWindow);
+        glViewport(0, 0, unixWindow->width, unixWindow->height);
+        glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+        clear_gl_buffers(unixApp);
+    }
+    else if (unixApp->appType == UNIX_APP_WAYLAND)
+    {
+        if (!unixWindow->data.waylandData.isConfigured)
+        {
+            return;
+        }
+
+        if (unixApp->egl.display == EGL_NO_DISPLAY)
+        {
+            int back = ensure_wayland_buffers(unixApp, unixWindow) ? find_wayland_back_buffer(unixWindow) : -1;
+            if (back >= 0)
+            {
+                /* opaque green in XRGB8888 */
+                UnixFramebuffer* framebuffer = &unixWindow->data.waylandData.framebuffer;
+                fill_window_pixels(unixWindow, framebuffer->memory + unixWindow->data.waylandData.buffers[back].offset, framebuffer->stride, 0xFF00FF00u);
+            }
+            return;
+        }
+
+        make_window_current(unixApp, unixWindow);
+        glViewport(0, 0, unixWindow->width, unixWindow->height);
         glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+        clear_gl_buffers(unixApp);
+    }
+    else if (unixApp->appType == UNIX_APP_HEADLESS)
+    {
+        if (unixApp->egl.display == EGL_NO_DISPLAY)
+        {
+            UnixFramebuffer* framebuffer = &unixWindow->data.headlessData.framebuffer;
+
+            /* opaque green in RGBA8 byte order */
+            uint8_t clearColor[4] = { 0, 255, 0, 255 };
+            uint32_t clearValue;
+            memcpy(&clearValue, clearColor, sizeof(clearValue));
+
+            if (resize_unix_framebuffer(framebuffer, unixWindow->width, unixWindow->height))
+            {
+                fill_window_pixels(unixWindow, get_unix_framebuffer_frame(framebuffer, 0), framebuffer->stride, clearValue);
+            }
+        }
+        else
+        {
+            make_window_current(unixApp, unixWindow);
+            glViewport(0, 0, unixWindow->width, unixWindow->height);
+            glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+            clear_gl_buffers(unixApp);
+        }
     }
 }
 
 void swap_window_buffers(AppHandle app, WindowHandle handle)
+{
+    swap_window_buffers_with_damage(app, handle, NULL, 0);
+}
+
+void swap_window_buffers_with_damage(AppHandle app, WindowHandle handle, const WindowRect* rects, int count)
 {
     UnixApp* unixApp = (UnixApp*)app;
     UnixWindow* unixWindow = (UnixWindow*)handle;
@@ -160,14 +343,1853 @@ void swap_window_buffers(AppHandle app, WindowHandle handle)
         return;
     }
 
+    if (count < 0 || (count > 0 && rects == NULL))
+    {
+        log_error("Invalid damage rects");
+        return;
+    }
+
     if (unixApp->appType == UNIX_APP_XORG)
     {
-        glXSwapBuffers(unixApp->data.xorgData.display, unixWindow->data.xorgData.rawHandle);
+        if (unixWindow->isSwapIntervalDirty)
+        {
+            apply_xorg_swap_interval(unixApp, unixWindow);
+        }
+
+        if (unixWindow->isSwapLimited)
+        {
+            limit_swap_rate(unixWindow);
+        }
+
+        if (unixApp->data.xorgData.glXGetSyncValuesOML != NULL)
+        {
+            record_oml_frame_timing(unixApp, unixWindow);
+        }
+
+        if (unixApp->config.softwareRendering)
+        {
+            present_xorg_image(unixApp, unixWindow, rects, count);
+        }
+        else if (unixApp->egl.display != EGL_NO_DISPLAY)
+        {
+            present_egl_surface(unixApp, unixWindow, rects, count);
+        }
+        else
+        {
+            /* the swap and the fence in limit_frames_in_flight both act on whatever context is current */
+            make_window_current(unixApp, unixWindow);
+
+            /* GLX has no way to pass damage on, but buffer age still saves the redraw */
+            glXSwapBuffers(unixApp->data.xorgData.display, unixWindow->data.xorgData.rawHandle);
+        }
+
+        atomic_store_explicit(&unixWindow->frameTime, get_monotonic_millis(), memory_order_relaxed);
+        record_window_damage(unixWindow, rects, count);
+
+        if (unixApp->data.xorgData.glXGetSyncValuesOML == NULL)
+        {
+            record_estimated_frame_timing(unixWindow, get_monotonic_nanos(), SOFTWARE_REFRESH_NANOS);
+        }
+
+        /* images are throttled by ShmCompletion instead, see is_window_ready_for_frame */
+        if (!unixApp->config.softwareRendering)
+        {
+            limit_frames_in_flight(unixWindow);
+        }
+    }
+    else if (unixApp->appType == UNIX_APP_WAYLAND)
+    {
+        if (unixWindow->data.waylandData.isConfigured)
+        {
+            /* the compositor tells us when it wants the next frame, and stays quiet while we're hidden */
+            if (unixWindow->data.waylandData.frameCallback == NULL)
+            {
+                unixWindow->data.waylandData.frameCallback = wl_surface_frame(unixWindow->data.waylandData.surface);
+                wl_callback_add_listener(unixWindow->data.waylandData.frameCallback, &frame_listener, unixWindow);
+            }
+
+            if (unixApp->egl.display == EGL_NO_DISPLAY)
+            {
+                present_wayland_buffer(unixApp, unixWindow, rects, count);
+            }
+            else
+            {
+                present_egl_surface(unixApp, unixWindow, rects, count);
+                limit_frames_in_flight(unixWindow);
+            }
+
+            record_window_damage(unixWindow, rects, count);
+        }
+    }
+    else if (unixApp->appType == UNIX_APP_HEADLESS)
+    {
+        /* pbuffers are single buffered, so just make sure the frame is submitted */
+        if (unixApp->egl.display != EGL_NO_DISPLAY)
+        {
+            glFlush();
+            limit_frames_in_flight(unixWindow);
+        }
+
+        /* there is no display to wait for, so any interval is paced in software */
+        if (unixWindow->isSwapIntervalDirty)
+        {
+            unixWindow->isSwapIntervalDirty = false;
+            unixWindow->isSwapLimited = unixWindow->swapInterval != 0;
+        }
+
+        if (unixWindow->isSwapLimited)
+        {
+            limit_swap_rate(unixWindow);
+        }
+
+        atomic_store_explicit(&unixWindow->frameTime, get_monotonic_millis(), memory_order_relaxed);
+        record_estimated_frame_timing(unixWindow, get_monotonic_nanos(), SOFTWARE_REFRESH_NANOS);
+        record_window_damage(unixWindow, rects, count);
     }
 
 }
 
-/***************************************************************
-** MARK: STATIC FUNCTIONS
-***************************************************************/
+int get_window_buffer_age(AppHandle app, WindowHandle handle)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return 0;
+    }
+
+    return query_buffer_age(unixApp, unixWindow);
+}
+
+void invalidate_window(AppHandle app, WindowHandle handle)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return;
+    }
+
+    if (unixApp->renderThread != NULL)
+    {
+        post_render_message(unixApp, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_INVALIDATE, .window = unixWindow });
+        return;
+    }
+
+    mark_window_dirty(unixWindow);
+}
+
+void invalidate_rect(AppHandle app, WindowHandle handle, WindowRect rect)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return;
+    }
+
+    if (unixApp->renderThread != NULL)
+    {
+        post_render_message(unixApp, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_INVALIDATE_RECT, .window = unixWindow, .data.rect = rect });
+        return;
+    }
+
+    apply_window_damage(unixWindow, rect);
+}
+
+void set_swap_interval(AppHandle app, WindowHandle handle, int interval)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return;
+    }
+
+    if (interval < -1)
+    {
+        log_error("Invalid swap interval %d", interval);
+        return;
+    }
+
+    if (unixApp->renderThread != NULL)
+    {
+        post_render_message(unixApp, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_SWAP_INTERVAL, .window = unixWindow, .data.swapInterval = interval });
+        return;
+    }
+
+    apply_swap_interval(unixWindow, interval);
+}
+
+void set_max_frames_in_flight(AppHandle app, WindowHandle handle, int count)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return;
+    }
+
+    if (count < 0 || count > UNIX_MAX_FRAMES_IN_FLIGHT)
+    {
+        log_error("Invalid frames in flight %d, must be between 0 and %d", count, UNIX_MAX_FRAMES_IN_FLIGHT);
+        return;
+    }
+
+    if (unixApp->renderThread != NULL)
+    {
+        post_render_message(unixApp, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_FRAMES_IN_FLIGHT, .window = unixWindow, .data.framesInFlight = count });
+        return;
+    }
+
+    apply_max_frames_in_flight(unixWindow, count);
+}
+
+uint32_t get_window_frame_time(AppHandle app, WindowHandle handle)
+{
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if ((UnixApp*)app == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return 0;
+    }
+
+    return atomic_load_explicit(&unixWindow->frameTime, memory_order_relaxed);
+}
+
+WindowFrameTiming get_window_frame_timing(AppHandle app, WindowHandle handle)
+{
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if ((UnixApp*)app == NULL || unixWindow == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return (WindowFrameTiming) { 0 };
+    }
+
+    WindowFrameTiming timing;
+    unsigned int seq;
+
+    /* the render thread may be mid-update, in which case read again */
+    do
+    {
+        seq = atomic_load_explicit(&unixWindow->timingSeq, memory_order_acquire);
+        timing = unixWindow->frameTiming;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != atomic_load_explicit(&unixWindow->timingSeq, memory_order_relaxed));
+
+    /* the recorded vblank goes stale when nothing has been drawn for a while */
+    uint64_t now = get_monotonic_nanos();
+    if (timing.refreshPeriod != 0 && timing.nextVblankTime != 0 && timing.nextVblankTime <= now)
+    {
+        uint64_t periods = (now - timing.nextVblankTime) / timing.refreshPeriod + 1;
+        timing.nextVblankTime += periods * timing.refreshPeriod;
+    }
+
+    return timing;
+}
+
+bool read_window_pixels(AppHandle app, WindowHandle handle, uint8_t* pixels, size_t size)
+{
+    UnixApp* unixApp = (UnixApp*)app;
+    UnixWindow* unixWindow = (UnixWindow*)handle;
+
+    if (unixApp == NULL || unixWindow == NULL || pixels == NULL)
+    {
+        log_error("Invalid app or window handle");
+        return false;
+    }
+
+    if (unixApp->appType != UNIX_APP_HEADLESS)
+    {
+        log_error("Reading back pixels is only supported by headless windows");
+        return false;
+    }
+
+    if (unixApp->renderThread != NULL)
+    {
+        log_error("Pixels can't be read back while the render thread is running");
+        return false;
+    }
+
+    size_t stride = (size_t)unixWindow->width * 4;
+    size_t required = stride * (size_t)unixWindow->height;
+
+    if (size < required)
+    {
+        log_error("Pixel buffer too small, %zu bytes needed", required);
+        return false;
+    }
+
+    if (unixApp->egl.display == EGL_NO_DISPLAY)
+    {
+        /* a window resized since its last frame has nothing meaningful to read yet, but the size still has to match */
+        UnixFramebuffer* framebuffer = &unixWindow->data.headlessData.framebuffer;
+        if (!resize_unix_framebuffer(framebuffer, unixWindow->width, unixWindow->height))
+        {
+            return false;
+        }
+
+        memcpy(pixels, get_unix_framebuffer_frame(framebuffer, 0), required);
+        return true;
+    }
+
+    make_window_current(unixApp, unixWindow);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, unixWindow->width, unixWindow->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    /* gl rows start at the bottom, swapped in place through a stack chunk so a read can't fail on an allocation */
+    uint8_t chunk[READ_PIXELS_SWAP_CHUNK];
+
+    for (int y = 0; y < unixWindow->height / 2; y++)
+    {
+        uint8_t* top = pixels + (size_t)y * stride;
+        uint8_t* bottom = pixels + (size_t)(unixWindow->height - 1 - y) * stride;
 
+        for (size_t x = 0; x < stride; x += sizeof(chunk))
+        {
+            size_t length = stride - x < sizeof(chunk) ? stride - x : sizeof(chunk);
+
+            memcpy(chunk, top + x, length);
+            memcpy(top + x, bottom + x, length);
+            memcpy(bottom + x, chunk, length);
+        }
+    }
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void make_window_current(UnixApp* app, UnixWindow* window)
+{
+    uintptr_t drawable = 0;
+    uintptr_t context = 0;
+
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        drawable = (uintptr_t)window->eglSurface;
+        context = (uintptr_t)window->eglContext;
+    }
+    else if (app->appType == UNIX_APP_XORG && window->data.xorgData.glContext != NULL)
+    {
+        drawable = (uintptr_t)window->data.xorgData.rawHandle;
+        context = (uintptr_t)window->data.xorgData.glContext;
+    }
+
+    /* switching the bound drawable is a driver round trip, skip it when nothing changes */
+    if (drawable == 0 || (drawable == app->currentDrawable && context == app->currentContext))
+    {
+        return;
+    }
+
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(app->egl.display, (EGLSurface)drawable, (EGLSurface)drawable, (EGLContext)context);
+    }
+    else
+    {
+        glXMakeCurrent(app->data.xorgData.display, (GLXDrawable)drawable, (GLXContext)context);
+    }
+
+    /* the conversion is context state, so contexts new to this window may not have it yet */
+    if (app->config.surfaceFormat.isSrgb)
+    {
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    }
+
+    app->currentDrawable = drawable;
+    app->currentContext = context;
+}
+
+bool is_window_ready_for_frame(UnixWindow* window)
+{
+    if (window->appType == UNIX_APP_XORG)
+    {
+        /* a software window can't draw into an image the server is still reading */
+        return window->data.xorgData.pendingPuts[window->data.xorgData.backImage] == 0;
+    }
+    else if (window->appType == UNIX_APP_WAYLAND)
+    {
+        /* an interval of 0 renders as fast as damage arrives instead of at the compositor's pace */
+        if (!window->data.waylandData.isConfigured || (window->data.waylandData.frameCallback != NULL && window->swapInterval != 0))
+        {
+            return false;
+        }
+
+        /* software windows also need a buffer the compositor has let go of, gl windows have no buffers here */
+        return window->data.waylandData.buffers[0].buffer == NULL || find_wayland_back_buffer(window) >= 0;
+    }
+
+    return true;
+}
+
+void destroy_unix_window(UnixApp* app, UnixWindow* window)
+{
+    if (app == NULL || window == NULL)
+    {
+        return;
+    }
+
+    /* events stop reaching the window straight away */
+    unregister_window(app, window);
+
+    /* the native window has to outlive anything the render thread may still draw into it */
+    if (app->renderThread != NULL && !window->isRetired)
+    {
+        post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_REMOVE_WINDOW, .window = window });
+        flush_render_messages(app);
+        return;
+    }
+
+    /* a retired window's gl was already released on the render thread, which still owns the current context */
+    if (!window->isRetired)
+    {
+        release_window_gl(app, window);
+    }
+
+    if (app->appType == UNIX_APP_XORG)
+    {
+        destroy_xorg_images(app, window);
+
+        if (window->data.xorgData.gc != NULL)
+        {
+            XFreeGC(app->data.xorgData.display, window->data.xorgData.gc);
+        }
+
+        XDestroyWindow(app->data.xorgData.display, window->data.xorgData.rawHandle);
+        XFlush(app->data.xorgData.display);
+    }
+    else if (app->appType == UNIX_APP_WAYLAND)
+    {
+        if (window->data.waylandData.eglWindow != NULL)
+        {
+            wl_egl_window_destroy(window->data.waylandData.eglWindow);
+        }
+
+        destroy_wayland_buffers(window);
+
+        if (window->data.waylandData.frameCallback != NULL)
+        {
+            wl_callback_destroy(window->data.waylandData.frameCallback);
+        }
+
+        if (window->data.waylandData.decoration != NULL)
+        {
+            zxdg_toplevel_decoration_v1_destroy(window->data.waylandData.decoration);
+        }
+
+        xdg_toplevel_destroy(window->data.waylandData.toplevel);
+        xdg_surface_destroy(window->data.waylandData.xdgSurface);
+        wl_surface_destroy(window->data.waylandData.surface);
+        wl_display_flush(app->data.waylandData.display);
+    }
+    else if (app->appType == UNIX_APP_HEADLESS)
+    {
+        destroy_unix_framebuffer(&window->data.headlessData.framebuffer);
+    }
+
+    free(window);
+}
+
+void release_window_gl(UnixApp* app, UnixWindow* window)
+{
+    /* fences belong to the window's context, so delete them while it can still be made current */
+    if (window->frameFenceCount > 0)
+    {
+        make_window_current(app, window);
+        release_frame_fences(window);
+    }
+
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        EGLDisplay eglDisplay = app->egl.display;
+
+        if (app->currentDrawable == (uintptr_t)window->eglSurface)
+        {
+            eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            app->currentDrawable = 0;
+            app->currentContext = 0;
+        }
+
+        if (window->eglSurface != EGL_NO_SURFACE)
+        {
+            eglDestroySurface(eglDisplay, window->eglSurface);
+        }
+
+        if (window->eglContext != EGL_NO_CONTEXT && window->eglContext != app->egl.sharedContext)
+        {
+            eglDestroyContext(eglDisplay, window->eglContext);
+        }
+
+        window->eglSurface = EGL_NO_SURFACE;
+        window->eglContext = EGL_NO_CONTEXT;
+    }
+    else if (app->appType == UNIX_APP_XORG)
+    {
+        Display* display = app->data.xorgData.display;
+
+        if (app->currentDrawable == (uintptr_t)window->data.xorgData.rawHandle)
+        {
+            glXMakeCurrent(display, None, NULL);
+            app->currentDrawable = 0;
+            app->currentContext = 0;
+        }
+
+        if (window->data.xorgData.glContext != NULL && window->data.xorgData.glContext != app->data.xorgData.sharedContext)
+        {
+            glXDestroyContext(display, window->data.xorgData.glContext);
+        }
+
+        window->data.xorgData.glContext = NULL;
+    }
+}
+
+void resize_unix_window(UnixApp* app, UnixWindow* window, int width, int height)
+{
+    if (app->renderThread != NULL)
+    {
+        post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_RESIZE, .window = window, .data.size = { width, height } });
+        return;
+    }
+
+    apply_window_resize(window, width, height);
+}
+
+void apply_window_damage(UnixWindow* window, WindowRect rect)
+{
+    /* clip to the window */
+    int left = rect.x > 0 ? rect.x : 0;
+    int top = rect.y > 0 ? rect.y : 0;
+    int right = rect.x + rect.width < window->width ? rect.x + rect.width : window->width;
+    int bottom = rect.y + rect.height < window->height ? rect.y + rect.height : window->height;
+
+    if (right <= left || bottom <= top)
+    {
+        return;
+    }
+
+    if (window->needsRedraw)
+    {
+        /* grow the pending damage to cover the new rect */
+        WindowRect* damage = &window->damageRect;
+
+        int damageRight = damage->x + damage->width;
+        int damageBottom = damage->y + damage->height;
+
+        left = left < damage->x ? left : damage->x;
+        top = top < damage->y ? top : damage->y;
+        right = right > damageRight ? right : damageRight;
+        bottom = bottom > damageBottom ? bottom : damageBottom;
+    }
+
+    window->needsRedraw = true;
+    window->damageRect = (WindowRect) { left, top, right - left, bottom - top };
+}
+
+void apply_window_resize(UnixWindow* window, int width, int height)
+{
+    if (width != window->width || height != window->height)
+    {
+        window->width = width;
+        window->height = height;
+        mark_window_dirty(window);
+    }
+}
+
+void apply_swap_interval(UnixWindow* window, int interval)
+{
+    window->swapInterval = interval;
+    window->isSwapIntervalDirty = true;
+    window->lastSwapNanos = 0;
+}
+
+void apply_max_frames_in_flight(UnixWindow* window, int count)
+{
+    /* fences beyond the new limit are waited on (or dropped) at the next swap */
+    window->maxFramesInFlight = count;
+}
+
+void apply_image_release(UnixWindow* window, ShmSeg segment)
+{
+    /* completions for images dropped by a resize match nothing and are ignored */
+    for (int i = 0; i < UNIX_XORG_IMAGE_COUNT; i++)
+    {
+        if (window->data.xorgData.images[i] != NULL && window->data.xorgData.shmSegments[i].shmseg == segment && window->data.xorgData.pendingPuts[i] > 0)
+        {
+            window->data.xorgData.pendingPuts[i]--;
+            return;
+        }
+    }
+}
+
+void apply_buffer_release(UnixWindow* window, struct wl_buffer* buffer)
+{
+    for (int i = 0; i < UNIX_WAYLAND_BUFFER_COUNT; i++)
+    {
+        if (window->data.waylandData.buffers[i].buffer == buffer)
+        {
+            window->data.waylandData.buffers[i].isBusy = false;
+            return;
+        }
+    }
+
+    /* a buffer from before a resize is done with for good */
+    for (int i = 0; i < UNIX_WAYLAND_STALE_BUFFER_COUNT; i++)
+    {
+        if (window->data.waylandData.staleBuffers[i].buffer == buffer)
+        {
+            wl_buffer_destroy(buffer);
+            window->data.waylandData.staleBuffers[i] = (UnixShmBuffer) { 0 };
+            return;
+        }
+    }
+}
+
+void release_xorg_image(UnixApp* app, UnixWindow* window, ShmSeg segment)
+{
+    if (app->renderThread != NULL)
+    {
+        post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_IMAGE_RELEASE, .window = window, .data.shmSegment = segment });
+        return;
+    }
+
+    apply_image_release(window, segment);
+}
+
+void render_unix_window(UnixApp* app, UnixWindow* window)
+{
+    /* a window that is still waiting for its frame callback keeps its damage for later */
+    if (!window->needsRedraw || !is_window_ready_for_frame(window))
+    {
+        return;
+    }
+
+    /* any number of invalidations since the last frame collapse into this one */
+    WindowRect damage = window->damageRect;
+    window->needsRedraw = false;
+    window->damageRect = (WindowRect) { 0, 0, 0, 0 };
+
+    /* an older back buffer also misses whatever the frames since it changed */
+    begin_window_repaint(app, window, get_repaint_rect(app, window, damage));
+    clear_window((AppHandle)app, (WindowHandle)window);
+    end_window_repaint(app, window);
+
+    swap_window_buffers_with_damage((AppHandle)app, (WindowHandle)window, &damage, 1);
+}
+
+/***************************************************************
+** MARK: STATIC FUNCTIONS
+***************************************************************/
+
+static WindowHandle_opt create_wayland_window(UnixApp* app, int width, int height, const char* title)
+{
+    UnixWindow* unixWindow = calloc(1, sizeof(UnixWindow));
+    unixWindow->title = title;
+    unixWindow->app = app;
+    unixWindow->appType = UNIX_APP_WAYLAND;
+    unixWindow->swapInterval = 1;
+    unixWindow->maxFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    unixWindow->width = width;
+    unixWindow->height = height;
+    unixWindow->configuredWidth = width;
+    unixWindow->configuredHeight = height;
+    unixWindow->needsRedraw = true;
+    unixWindow->damageRect = (WindowRect) { 0, 0, width, height };
+    unixWindow->eglSurface = EGL_NO_SURFACE;
+    unixWindow->eglContext = EGL_NO_CONTEXT;
+    init_unix_framebuffer(&unixWindow->data.waylandData.framebuffer, UNIX_FRAMEBUFFER_MEMFD, UNIX_WAYLAND_BUFFER_COUNT);
+
+    /* create the xdg toplevel */
+    struct wl_surface* surface = wl_compositor_create_surface(app->data.waylandData.compositor);
+    struct xdg_surface* xdgSurface = xdg_wm_base_get_xdg_surface(app->data.waylandData.wmBase, surface);
+    struct xdg_toplevel* toplevel = xdg_surface_get_toplevel(xdgSurface);
+
+    unixWindow->data.waylandData.surface = surface;
+    unixWindow->data.waylandData.xdgSurface = xdgSurface;
+    unixWindow->data.waylandData.toplevel = toplevel;
+
+    if (!register_window(app, (uintptr_t)surface, unixWindow))
+    {
+        destroy_unix_window(app, unixWindow);
+        return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    xdg_surface_add_listener(xdgSurface, &xdg_surface_listener, unixWindow);
+    xdg_toplevel_add_listener(toplevel, &toplevel_listener, unixWindow);
+    xdg_toplevel_set_title(toplevel, title);
+    xdg_toplevel_set_app_id(toplevel, app->title);
+
+    /* ask for server side decorations where the compositor offers them */
+    if (app->data.waylandData.decorationManager != NULL)
+    {
+        unixWindow->data.waylandData.decoration = zxdg_decoration_manager_v1_get_toplevel_decoration(app->data.waylandData.decorationManager, toplevel);
+        zxdg_toplevel_decoration_v1_set_mode(unixWindow->data.waylandData.decoration, ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
+    }
+
+    /* the surface can't have a buffer attached until the first configure */
+    wl_surface_commit(surface);
+
+    while (!unixWindow->data.waylandData.isConfigured)
+    {
+        if (wl_display_dispatch(app->data.waylandData.display) < 0)
+        {
+            log_error("Lost the Wayland connection");
+            destroy_unix_window(app, unixWindow);
+            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+    }
+
+    /* software windows make their buffers on first draw */
+    if (app->egl.display == EGL_NO_DISPLAY)
+    {
+        return (WindowHandle_opt) { .value = (intptr_t)unixWindow, .is_some = true };
+    }
+
+    /* Create an OpenGL 3.3 context */
+
+    unixWindow->data.waylandData.eglWindow = wl_egl_window_create(surface, unixWindow->width, unixWindow->height);
+    if (!create_egl_surface(app, unixWindow, unixWindow->data.waylandData.eglWindow))
+    {
+        destroy_unix_window(app, unixWindow);
+        return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    make_window_current(app, unixWindow);
+
+    /* pacing comes from frame callbacks, so eglSwapBuffers must never block on its own */
+    eglSwapInterval(app->egl.display, 0);
+
+    log_info("Initialised OpenGL %s", glGetString(GL_VERSION));
+
+    return (WindowHandle_opt) { .value = (intptr_t)unixWindow, .is_some = true };
+}
+
+static WindowHandle_opt create_headless_window(UnixApp* app, int width, int height, const char* title)
+{
+    if (width <= 0 || height <= 0)
+    {
+        log_error("Invalid window size %d x %d", width, height);
+        return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    UnixWindow* unixWindow = calloc(1, sizeof(UnixWindow));
+    unixWindow->title = title;
+    unixWindow->app = app;
+    unixWindow->appType = UNIX_APP_HEADLESS;
+    unixWindow->maxFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    unixWindow->width = width;
+    unixWindow->height = height;
+    unixWindow->configuredWidth = width;
+    unixWindow->configuredHeight = height;
+    unixWindow->needsRedraw = true;
+    unixWindow->damageRect = (WindowRect) { 0, 0, width, height };
+    unixWindow->eglSurface = EGL_NO_SURFACE;
+    unixWindow->eglContext = EGL_NO_CONTEXT;
+
+    if (app->egl.display == EGL_NO_DISPLAY)
+    {
+        init_unix_framebuffer(&unixWindow->data.headlessData.framebuffer, UNIX_FRAMEBUFFER_HEAP, 1);
+
+        if (!resize_unix_framebuffer(&unixWindow->data.headlessData.framebuffer, width, height))
+        {
+            free(unixWindow);
+            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+
+        if (!attach_window(app, (uintptr_t)unixWindow, unixWindow))
+        {
+            destroy_unix_window(app, unixWindow);
+            return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+        }
+
+        return (WindowHandle_opt) { .value = (intptr_t)unixWindow, .is_some = true };
+    }
+
+    /* Create an OpenGL 3.3 context rendering into a pbuffer */
+
+    if (!create_egl_surface(app, unixWindow, NULL))
+    {
+        destroy_unix_window(app, unixWindow);
+        return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    if (app->renderThread == NULL)
+    {
+        make_window_current(app, unixWindow);
+
+        log_info("Initialised OpenGL %s", glGetString(GL_VERSION));
+    }
+
+    if (!attach_window(app, (uintptr_t)unixWindow, unixWindow))
+    {
+        destroy_unix_window(app, unixWindow);
+        return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = false };
+    }
+
+    return (WindowHandle_opt) { .value = (intptr_t)unixWindow, .is_some = true };
+}
+
+static GLXContext acquire_xorg_context(UnixApp* app)
+{
+    PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB = NULL;
+    glXCreateContextAttribsARB = (PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB((const GLubyte *)"glXCreateContextAttribsARB");
+
+    if (!glXCreateContextAttribsARB) {
+        log_error("glXCreateContextAttribsARB not found");
+        return NULL;
+    }
+
+    Display* display = app->data.xorgData.display;
+    AppGlContextMode mode = app->config.glContextMode;
+
+    if (mode != APP_GL_CONTEXT_PER_WINDOW && app->data.xorgData.sharedContext == NULL)
+    {
+        app->data.xorgData.sharedContext = glXCreateContextAttribsARB(display, app->data.xorgData.bestFbc, NULL, True, context_attribs);
+        if (!app->data.xorgData.sharedContext) {
+            log_error("Failed to create OpenGL context");
+            return NULL;
+        }
+    }
+
+    if (mode == APP_GL_CONTEXT_SINGLE)
+    {
+        return app->data.xorgData.sharedContext;
+    }
+
+    GLXContext context = glXCreateContextAttribsARB(display, app->data.xorgData.bestFbc, app->data.xorgData.sharedContext, True, context_attribs);
+    if (!context) {
+        log_error("Failed to create OpenGL context");
+    }
+
+    return context;
+}
+
+static EGLContext acquire_egl_context(UnixApp* app)
+{
+    AppGlContextMode mode = app->config.glContextMode;
+    EGLDisplay display = app->egl.display;
+    EGLConfig config = app->egl.config;
+
+    if (mode != APP_GL_CONTEXT_PER_WINDOW && app->egl.sharedContext == EGL_NO_CONTEXT)
+    {
+        app->egl.sharedContext = eglCreateContext(display, config, EGL_NO_CONTEXT, egl_context_attribs);
+        if (app->egl.sharedContext == EGL_NO_CONTEXT)
+        {
+            log_error("Failed to create OpenGL context (0x%x)", eglGetError());
+            return EGL_NO_CONTEXT;
+        }
+    }
+
+    if (mode == APP_GL_CONTEXT_SINGLE)
+    {
+        return app->egl.sharedContext;
+    }
+
+    EGLContext context = eglCreateContext(display, config, app->egl.sharedContext, egl_context_attribs);
+    if (context == EGL_NO_CONTEXT)
+    {
+        log_error("Failed to create OpenGL context (0x%x)", eglGetError());
+    }
+
+    return context;
+}
+
+static bool create_egl_surface(UnixApp* app, UnixWindow* window, void* nativeWindow)
+{
+    window->eglContext = acquire_egl_context(app);
+    if (window->eglContext == EGL_NO_CONTEXT)
+    {
+        return false;
+    }
+
+    bool isSrgb = app->config.surfaceFormat.isSrgb && app->egl.hasGlColorspace;
+
+    /* without a native window the surface is an offscreen pbuffer */
+    if (nativeWindow != NULL)
+    {
+        EGLAttrib surfaceAttribs[] = {
+            EGL_GL_COLORSPACE_KHR, EGL_GL_COLORSPACE_SRGB_KHR,
+            EGL_NONE
+        };
+
+        window->eglSurface = eglCreatePlatformWindowSurface(app->egl.display, app->egl.config, nativeWindow, isSrgb ? surfaceAttribs : NULL);
+    }
+    else
+    {
+        EGLint pbufferAttribs[] = {
+            EGL_WIDTH, window->width,
+            EGL_HEIGHT, window->height,
+            isSrgb ? EGL_GL_COLORSPACE_KHR : EGL_NONE, EGL_GL_COLORSPACE_SRGB_KHR,
+            EGL_NONE
+        };
+
+        window->eglSurface = eglCreatePbufferSurface(app->egl.display, app->egl.config, pbufferAttribs);
+    }
+
+    if (window->eglSurface == EGL_NO_SURFACE)
+    {
+        log_error("Failed to create EGL surface (0x%x)", eglGetError());
+        return false;
+    }
+
+    return true;
+}
+
+static bool attach_window(UnixApp* app, uintptr_t key, UnixWindow* window)
+{
+    if (!register_window(app, key, window))
+    {
+        return false;
+    }
+
+    if (app->renderThread != NULL)
+    {
+        post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_ADD_WINDOW, .window = window });
+    }
+
+    /* there is no server to expose headless windows, so report the first one here */
+    if (app->appType == UNIX_APP_HEADLESS)
+    {
+        push_app_event(app, (AngeloEvent) {
+            .type = ANGELO_EVENT_WINDOW_EXPOSE,
+            .window = (WindowHandle)window,
+            .data.expose = { 0, 0, window->width, window->height }
+        });
+    }
+
+    return true;
+}
+
+static void apply_xorg_swap_interval(UnixApp* app, UnixWindow* window)
+{
+    int interval = window->swapInterval;
+
+    window->isSwapIntervalDirty = false;
+    window->isSwapLimited = false;
+
+    if (interval < 0 && !app->data.xorgData.hasSwapControlTear)
+    {
+        /* without tear control the closest we get is plain vsync */
+        interval = 1;
+    }
+
+    if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        /* the egl interval belongs to whatever surface is current */
+        make_window_current(app, window);
+        window->isSwapLimited = !eglSwapInterval(app->egl.display, interval) && interval != 0;
+        return;
+    }
+
+    if (app->data.xorgData.glXSwapIntervalEXT != NULL)
+    {
+        app->data.xorgData.glXSwapIntervalEXT(app->data.xorgData.display, window->data.xorgData.rawHandle, interval);
+    }
+    else if (app->data.xorgData.glXSwapIntervalMESA != NULL)
+    {
+        /* the mesa extension sets the interval of whatever drawable is current */
+        make_window_current(app, window);
+        app->data.xorgData.glXSwapIntervalMESA((unsigned int)(interval < 0 ? 1 : interval));
+    }
+    else
+    {
+        window->isSwapLimited = interval != 0;
+    }
+}
+
+static void limit_swap_rate(UnixWindow* window)
+{
+    uint64_t period = (uint64_t)(window->swapInterval < 0 ? 1 : window->swapInterval) * SOFTWARE_REFRESH_NANOS;
+    uint64_t target = window->lastSwapNanos + period;
+    uint64_t now = get_monotonic_nanos();
+
+    if (window->lastSwapNanos != 0 && target > now)
+    {
+        struct timespec deadline = { .tv_sec = (time_t)(target / 1000000000ull), .tv_nsec = (long)(target % 1000000000ull) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+        {
+        }
+
+        window->lastSwapNanos = target;
+    }
+    else
+    {
+        /* a late (or first) frame starts a new cadence rather than bursting to catch up */
+        window->lastSwapNanos = now;
+    }
+}
+
+static void record_oml_frame_timing(UnixApp* app, UnixWindow* window)
+{
+    Display* display = app->data.xorgData.display;
+    Window drawable = window->data.xorgData.rawHandle;
+    int64_t ust, msc, sbc;
+
+    if (!app->data.xorgData.glXGetSyncValuesOML(display, drawable, &ust, &msc, &sbc))
+    {
+        return;
+    }
+
+    WindowFrameTiming timing = window->frameTiming;
+
+    if (!window->data.xorgData.isSbcSynced)
+    {
+        window->data.xorgData.isSbcSynced = true;
+        window->data.xorgData.issuedSbc = sbc;
+        window->data.xorgData.presentedSbc = sbc;
+
+        int32_t numerator, denominator;
+        if (app->data.xorgData.glXGetMscRateOML != NULL
+            && app->data.xorgData.glXGetMscRateOML(display, drawable, &numerator, &denominator)
+            && numerator > 0)
+        {
+            timing.refreshPeriod = (uint64_t)denominator * 1000000000ull / (uint64_t)numerator;
+        }
+        else
+        {
+            timing.refreshPeriod = SOFTWARE_REFRESH_NANOS;
+        }
+    }
+
+    /* once the last swap has completed, waiting on it returns straight away with when it was shown */
+    if (window->data.xorgData.issuedSbc > window->data.xorgData.presentedSbc && sbc >= window->data.xorgData.issuedSbc)
+    {
+        int64_t presentUst, presentMsc, presentSbc;
+        if (app->data.xorgData.glXWaitForSbcOML(display, drawable, window->data.xorgData.issuedSbc, &presentUst, &presentMsc, &presentSbc))
+        {
+            timing.lastPresentTime = (uint64_t)presentUst * 1000;
+
+            if (presentMsc > window->data.xorgData.targetMsc)
+            {
+                timing.missedFrames += (uint32_t)(presentMsc - window->data.xorgData.targetMsc);
+            }
+        }
+
+        window->data.xorgData.presentedSbc = window->data.xorgData.issuedSbc;
+    }
+
+    /* ust is microseconds on the monotonic clock for every driver that matters */
+    timing.nextVblankTime = (uint64_t)ust * 1000 + timing.refreshPeriod;
+    timing.isPrecise = true;
+    publish_frame_timing(window, timing);
+
+    /* the swap about to be issued, and the earliest vblank it can be shown at */
+    window->data.xorgData.issuedSbc++;
+    window->data.xorgData.targetMsc = msc + (window->swapInterval < 0 ? 1 : window->swapInterval);
+}
+
+static void record_estimated_frame_timing(UnixWindow* window, uint64_t presentTime, uint64_t refreshPeriod)
+{
+    WindowFrameTiming timing = window->frameTiming;
+
+    timing.lastPresentTime = presentTime;
+    timing.refreshPeriod = refreshPeriod;
+    timing.nextVblankTime = presentTime + refreshPeriod;
+    timing.isPrecise = false;
+    publish_frame_timing(window, timing);
+}
+
+static void publish_frame_timing(UnixWindow* window, WindowFrameTiming timing)
+{
+    /* only the rendering thread writes, so a plain sequence lock is enough */
+    unsigned int seq = atomic_load_explicit(&window->timingSeq, memory_order_relaxed);
+
+    atomic_store_explicit(&window->timingSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    window->frameTiming = timing;
+    atomic_store_explicit(&window->timingSeq, seq + 2, memory_order_release);
+}
+
+static void limit_frames_in_flight(UnixWindow* window)
+{
+    if (window->maxFramesInFlight == 0)
+    {
+        release_frame_fences(window);
+        return;
+    }
+
+    /* drop the oldest fence if a lowered limit left no room for this frame's */
+    if (window->frameFenceCount == UNIX_MAX_FRAMES_IN_FLIGHT)
+    {
+        glDeleteSync(window->frameFences[0]);
+        memmove(&window->frameFences[0], &window->frameFences[1], (size_t)(--window->frameFenceCount) * sizeof(GLsync));
+    }
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence == NULL)
+    {
+        return;
+    }
+
+    window->frameFences[window->frameFenceCount++] = fence;
+
+    /* this frame counts as in flight too, so a limit of one waits for it to finish */
+    int finished = window->frameFenceCount - window->maxFramesInFlight + 1;
+    if (finished <= 0)
+    {
+        return;
+    }
+
+    /* waiting on the newest fence that must be done covers every older one */
+    uint64_t waitStart = get_monotonic_nanos();
+    GLenum result = glClientWaitSync(window->frameFences[finished - 1], GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_FENCE_TIMEOUT_NANOS);
+    uint64_t waited = get_monotonic_nanos() - waitStart;
+
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+    {
+        log_warn("Gave up waiting for frame fence");
+    }
+
+    for (int i = 0; i < finished; i++)
+    {
+        glDeleteSync(window->frameFences[i]);
+    }
+
+    window->frameFenceCount -= finished;
+    memmove(&window->frameFences[0], &window->frameFences[finished], (size_t)window->frameFenceCount * sizeof(GLsync));
+
+    WindowFrameTiming timing = window->frameTiming;
+    timing.cpuWaitTime = waited;
+    publish_frame_timing(window, timing);
+}
+
+static void release_frame_fences(UnixWindow* window)
+{
+    for (int i = 0; i < window->frameFenceCount; i++)
+    {
+        glDeleteSync(window->frameFences[i]);
+    }
+
+    window->frameFenceCount = 0;
+}
+
+static void present_egl_surface(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count)
+{
+    /* egl only swaps surfaces bound to the calling thread */
+    make_window_current(app, window);
+
+    if (count == 0 || app->egl.eglSwapBuffersWithDamage == NULL)
+    {
+        eglSwapBuffers(app->egl.display, window->eglSurface);
+        return;
+    }
+
+    EGLint eglRects[MAX_DAMAGE_RECTS * 4];
+    int eglCount = 0;
+
+    /* egl counts rows from the bottom, and too many rects are sent as their bounds */
+    if (count > MAX_DAMAGE_RECTS)
+    {
+        WindowRect bounds = rects[0];
+        for (int i = 1; i < count; i++)
+        {
+            bounds = unite_rects(bounds, rects[i]);
+        }
+
+        rects = &bounds;
+        count = 1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (rects[i].width <= 0 || rects[i].height <= 0)
+        {
+            continue;
+        }
+
+        eglRects[eglCount * 4 + 0] = rects[i].x;
+        eglRects[eglCount * 4 + 1] = window->height - rects[i].y - rects[i].height;
+        eglRects[eglCount * 4 + 2] = rects[i].width;
+        eglRects[eglCount * 4 + 3] = rects[i].height;
+        eglCount++;
+    }
+
+    /* an empty list damages the whole surface, which is what a swap without rects means anyway */
+    app->egl.eglSwapBuffersWithDamage(app->egl.display, window->eglSurface, eglRects, eglCount);
+}
+
+static void record_window_damage(UnixWindow* window, const WindowRect* rects, int count)
+{
+    WindowRect bounds = { 0, 0, window->width, window->height };
+
+    if (count > 0)
+    {
+        bounds = rects[0];
+        for (int i = 1; i < count; i++)
+        {
+            bounds = unite_rects(bounds, rects[i]);
+        }
+    }
+
+    if (window->damageHistoryCount < UNIX_DAMAGE_HISTORY)
+    {
+        window->damageHistoryCount++;
+    }
+
+    memmove(&window->damageHistory[1], &window->damageHistory[0], (size_t)(window->damageHistoryCount - 1) * sizeof(WindowRect));
+    window->damageHistory[0] = bounds;
+}
+
+static int query_buffer_age(UnixApp* app, UnixWindow* window)
+{
+    EGLint age = 0;
+
+    if (app->appType == UNIX_APP_HEADLESS)
+    {
+        /* pbuffers and cpu framebuffers are single buffered, so they always hold the last frame */
+        age = window->damageHistoryCount > 0 ? 1 : 0;
+    }
+    else if (app->appType == UNIX_APP_XORG && app->config.softwareRendering)
+    {
+        int back = window->data.xorgData.backImage;
+        XImage* image = window->data.xorgData.images[back];
+        uint64_t presented = window->data.xorgData.imagePresents[back];
+
+        /* a missing or stale sized image is recreated before drawing, so it holds nothing */
+        if (image != NULL && image->width == window->width && image->height == window->height && presented != 0)
+        {
+            age = (EGLint)(window->data.xorgData.presentCount - presented + 1);
+        }
+    }
+    else if (app->appType == UNIX_APP_WAYLAND && app->egl.display == EGL_NO_DISPLAY)
+    {
+        int back = find_wayland_back_buffer(window);
+        bool isCurrent = window->data.waylandData.framebuffer.width == window->width && window->data.waylandData.framebuffer.height == window->height;
+
+        if (back >= 0 && isCurrent && window->data.waylandData.buffers[back].presentIndex != 0)
+        {
+            age = (EGLint)(window->data.waylandData.presentCount - window->data.waylandData.buffers[back].presentIndex + 1);
+        }
+    }
+    else if (app->egl.display != EGL_NO_DISPLAY)
+    {
+        if (app->egl.hasBufferAge && window->eglSurface != EGL_NO_SURFACE)
+        {
+            make_window_current(app, window);
+            if (!eglQuerySurface(app->egl.display, window->eglSurface, EGL_BUFFER_AGE_EXT, &age))
+            {
+                age = 0;
+            }
+        }
+    }
+    else if (app->data.xorgData.hasBufferAge)
+    {
+        unsigned int glxAge = 0;
+        make_window_current(app, window);
+        glXQueryDrawable(app->data.xorgData.display, window->data.xorgData.rawHandle, GLX_BACK_BUFFER_AGE_EXT, &glxAge);
+        age = (EGLint)glxAge;
+    }
+
+    return (int)age;
+}
+
+static WindowRect get_repaint_rect(UnixApp* app, UnixWindow* window, WindowRect damage)
+{
+    WindowRect whole = { 0, 0, window->width, window->height };
+    int age = query_buffer_age(app, window);
+
+    if (age == 0 || age - 1 > window->damageHistoryCount)
+    {
+        return whole;
+    }
+
+    for (int i = 0; i < age - 1; i++)
+    {
+        damage = unite_rects(damage, window->damageHistory[i]);
+    }
+
+    return damage;
+}
+
+static void begin_window_repaint(UnixApp* app, UnixWindow* window, WindowRect rect)
+{
+    if (is_cpu_window(app, window))
+    {
+        window->clipRect = rect;
+        return;
+    }
+
+    make_window_current(app, window);
+
+    int bottom = window->height - rect.y - rect.height;
+
+    /* tilers can skip loading whatever lies outside the region */
+    if (app->appType != UNIX_APP_HEADLESS && app->egl.eglSetDamageRegion != NULL)
+    {
+        EGLint region[4] = { rect.x, bottom, rect.width, rect.height };
+        app->egl.eglSetDamageRegion(app->egl.display, window->eglSurface, region, 1);
+    }
+
+    if (rect.x > 0 || rect.y > 0 || rect.width < window->width || rect.height < window->height)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(rect.x, bottom, rect.width, rect.height);
+    }
+}
+
+static void end_window_repaint(UnixApp* app, UnixWindow* window)
+{
+    if (is_cpu_window(app, window))
+    {
+        window->clipRect = (WindowRect) { 0, 0, 0, 0 };
+        return;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void clear_gl_buffers(UnixApp* app)
+{
+    GLbitfield mask = GL_COLOR_BUFFER_BIT;
+
+    /* the config may carry buffers nobody asked for, clearing those is wasted bandwidth */
+    if (app->config.surfaceFormat.depthBits > 0)
+    {
+        mask |= GL_DEPTH_BUFFER_BIT;
+    }
+
+    if (app->config.surfaceFormat.stencilBits > 0)
+    {
+        mask |= GL_STENCIL_BUFFER_BIT;
+    }
+
+    glClear(mask);
+}
+
+static bool is_cpu_window(UnixApp* app, UnixWindow* window)
+{
+    if (app->appType == UNIX_APP_XORG)
+    {
+        return app->config.softwareRendering;
+    }
+    else if (app->appType == UNIX_APP_WAYLAND)
+    {
+        return app->egl.display == EGL_NO_DISPLAY;
+    }
+
+    return app->appType == UNIX_APP_HEADLESS && app->egl.display == EGL_NO_DISPLAY;
+}
+
+static void fill_window_pixels(UnixWindow* window, uint8_t* pixels, size_t stride, uint32_t value)
+{
+    WindowRect rect = window->clipRect;
+
+    if (rect.width <= 0 || rect.height <= 0)
+    {
+        rect = (WindowRect) { 0, 0, window->width, window->height };
+    }
+
+    int left = rect.x > 0 ? rect.x : 0;
+    int top = rect.y > 0 ? rect.y : 0;
+    int right = rect.x + rect.width < window->width ? rect.x + rect.width : window->width;
+    int bottom = rect.y + rect.height < window->height ? rect.y + rect.height : window->height;
+
+    for (int y = top; y < bottom; y++)
+    {
+        uint32_t* row = (uint32_t*)(pixels + (size_t)y * stride);
+
+        for (int x = left; x < right; x++)
+        {
+            row[x] = value;
+        }
+    }
+}
+
+static bool ensure_xorg_images(UnixApp* app, UnixWindow* window)
+{
+    XImage* image = window->data.xorgData.images[0];
+
+    if (image != NULL && image->width == window->width && image->height == window->height)
+    {
+        return true;
+    }
+
+    for (int i = 0; i < UNIX_XORG_IMAGE_COUNT; i++)
+    {
+        if (!create_xorg_image(app, window, i))
+        {
+            log_error("Failed to create a window image");
+            destroy_xorg_images(app, window);
+            return false;
+        }
+    }
+
+    /* fills write whole 32 bit pixels */
+    if (window->data.xorgData.images[0]->bits_per_pixel != 32)
+    {
+        log_error("Software rendering needs a 32 bit visual");
+        destroy_xorg_images(app, window);
+        return false;
+    }
+
+    return true;
+}
+
+static bool create_xorg_image(UnixApp* app, UnixWindow* window, int index)
+{
+    Display* display = app->data.xorgData.display;
+    XVisualInfo* vi = app->data.xorgData.visualInfo;
+    UnixFramebuffer* framebuffer = &window->data.xorgData.framebuffers[index];
+    uint32_t generation = framebuffer->generation;
+
+    if (!resize_unix_framebuffer(framebuffer, window->width, window->height))
+    {
+        return false;
+    }
+
+    /* the image itself is only a description of the framebuffer, so it is remade at every size */
+    if (window->data.xorgData.images[index] != NULL)
+    {
+        window->data.xorgData.images[index]->data = NULL;
+        XDestroyImage(window->data.xorgData.images[index]);
+        window->data.xorgData.images[index] = NULL;
+    }
+
+    XImage* image = NULL;
+
+    if (app->data.xorgData.hasShm)
+    {
+        XShmSegmentInfo* segment = &window->data.xorgData.shmSegments[index];
+
+        /* a segment the framebuffer outgrew is swapped for its replacement, the server handles requests in order so earlier puts still read the old one */
+        if (segment->shmaddr == NULL || framebuffer->generation != generation)
+        {
+            if (segment->shmaddr != NULL)
+            {
+                XShmDetach(display, segment);
+                window->data.xorgData.pendingPuts[index] = 0;
+            }
+
+            segment->shmid = framebuffer->shmId;
+            segment->shmaddr = (char*)framebuffer->memory;
+            segment->readOnly = False;
+            XShmAttach(display, segment);
+        }
+
+        image = XShmCreateImage(display, vi->visual, (unsigned int)vi->depth, ZPixmap, (char*)framebuffer->memory, segment, (unsigned int)window->width, (unsigned int)window->height);
+    }
+    else
+    {
+        image = XCreateImage(display, vi->visual, (unsigned int)vi->depth, ZPixmap, 0, (char*)framebuffer->memory, (unsigned int)window->width, (unsigned int)window->height, 32, (int)framebuffer->stride);
+    }
+
+    if (image == NULL)
+    {
+        return false;
+    }
+
+    window->data.xorgData.images[index] = image;
+    window->data.xorgData.imagePresents[index] = 0;
+    return true;
+}
+
+static void destroy_xorg_images(UnixApp* app, UnixWindow* window)
+{
+    Display* display = app->data.xorgData.display;
+
+    for (int i = 0; i < UNIX_XORG_IMAGE_COUNT; i++)
+    {
+        /* the framebuffer owns the pixels, not the image */
+        if (window->data.xorgData.images[i] != NULL)
+        {
+            window->data.xorgData.images[i]->data = NULL;
+            XDestroyImage(window->data.xorgData.images[i]);
+        }
+
+        if (window->data.xorgData.shmSegments[i].shmaddr != NULL)
+        {
+            XShmDetach(display, &window->data.xorgData.shmSegments[i]);
+        }
+
+        destroy_unix_framebuffer(&window->data.xorgData.framebuffers[i]);
+
+        window->data.xorgData.images[i] = NULL;
+        window->data.xorgData.shmSegments[i] = (XShmSegmentInfo) { 0 };
+        window->data.xorgData.pendingPuts[i] = 0;
+        window->data.xorgData.imagePresents[i] = 0;
+    }
+
+    window->data.xorgData.backImage = 0;
+}
+
+static void present_xorg_image(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count)
+{
+    Display* display = app->data.xorgData.display;
+    int back = window->data.xorgData.backImage;
+    XImage* image = window->data.xorgData.images[back];
+
+    if (image == NULL)
+    {
+        return;
+    }
+
+    WindowRect whole = { 0, 0, image->width, image->height };
+    if (count == 0)
+    {
+        rects = &whole;
+        count = 1;
+    }
+
+    /* only the damage goes to the server, each put is answered with its own completion */
+    for (int i = 0; i < count; i++)
+    {
+        int left = rects[i].x > 0 ? rects[i].x : 0;
+        int top = rects[i].y > 0 ? rects[i].y : 0;
+        int right = rects[i].x + rects[i].width < image->width ? rects[i].x + rects[i].width : image->width;
+        int bottom = rects[i].y + rects[i].height < image->height ? rects[i].y + rects[i].height : image->height;
+
+        if (right <= left || bottom <= top)
+        {
+            continue;
+        }
+
+        if (app->data.xorgData.hasShm)
+        {
+            XShmPutImage(display, window->data.xorgData.rawHandle, window->data.xorgData.gc, image, left, top, left, top, (unsigned int)(right - left), (unsigned int)(bottom - top), True);
+            window->data.xorgData.pendingPuts[back]++;
+        }
+        else
+        {
+            XPutImage(display, window->data.xorgData.rawHandle, window->data.xorgData.gc, image, left, top, left, top, (unsigned int)(right - left), (unsigned int)(bottom - top));
+        }
+    }
+
+    window->data.xorgData.imagePresents[back] = ++window->data.xorgData.presentCount;
+    window->data.xorgData.backImage = (back + 1) % UNIX_XORG_IMAGE_COUNT;
+
+    XFlush(display);
+}
+
+static bool ensure_wayland_buffers(UnixApp* app, UnixWindow* window)
+{
+    UnixFramebuffer* framebuffer = &window->data.waylandData.framebuffer;
+
+    if (window->data.waylandData.buffers[0].buffer != NULL && framebuffer->width == window->width && framebuffer->height == window->height)
+    {
+        return true;
+    }
+
+    /* the compositor may still read from buffers it holds, so those are only set aside */
+    for (int i = 0; i < UNIX_WAYLAND_BUFFER_COUNT; i++)
+    {
+        UnixShmBuffer* buffer = &window->data.waylandData.buffers[i];
+
+        if (buffer->buffer != NULL && (!buffer->isBusy || !retire_wayland_buffer(window, buffer)))
+        {
+            wl_buffer_destroy(buffer->buffer);
+        }
+
+        *buffer = (UnixShmBuffer) { 0 };
+    }
+
+    /* the new buffers go after any bytes still held, the file never shrinks so these stay valid */
+    size_t frameSize = (size_t)window->width * FRAMEBUFFER_BYTES_PER_PIXEL * (size_t)window->height;
+    int firstFrame = find_wayland_first_frame(window, frameSize);
+
+    framebuffer->frameCount = firstFrame + UNIX_WAYLAND_BUFFER_COUNT;
+    if (!resize_unix_framebuffer(framebuffer, window->width, window->height))
+    {
+        return false;
+    }
+
+    /* the pool follows the file, which only ever grows */
+    if (window->data.waylandData.shmPool == NULL)
+    {
+        window->data.waylandData.shmPool = wl_shm_create_pool(app->data.waylandData.shm, framebuffer->fd, (int32_t)framebuffer->capacity);
+        window->data.waylandData.shmPoolSize = framebuffer->capacity;
+    }
+    else if (framebuffer->capacity > window->data.waylandData.shmPoolSize)
+    {
+        wl_shm_pool_resize(window->data.waylandData.shmPool, (int32_t)framebuffer->capacity);
+        window->data.waylandData.shmPoolSize = framebuffer->capacity;
+    }
+
+    for (int i = 0; i < UNIX_WAYLAND_BUFFER_COUNT; i++)
+    {
+        UnixShmBuffer* buffer = &window->data.waylandData.buffers[i];
+
+        buffer->offset = framebuffer->frameSize * (size_t)(firstFrame + i);
+        buffer->size = framebuffer->frameSize;
+        buffer->buffer = wl_shm_pool_create_buffer(window->data.waylandData.shmPool, (int32_t)buffer->offset, window->width, window->height, (int32_t)framebuffer->stride, WL_SHM_FORMAT_XRGB8888);
+        wl_buffer_add_listener(buffer->buffer, &buffer_listener, window);
+    }
+
+    return true;
+}
+
+static void destroy_wayland_buffers(UnixWindow* window)
+{
+    for (int i = 0; i < UNIX_WAYLAND_BUFFER_COUNT; i++)
+    {
+        if (window->data.waylandData.buffers[i].buffer != NULL)
+        {
+            wl_buffer_destroy(window->data.waylandData.buffers[i].buffer);
+        }
+
+        window->data.waylandData.buffers[i] = (UnixShmBuffer) { 0 };
+    }
+
+    for (int i = 0; i < UNIX_WAYLAND_STALE_BUFFER_COUNT; i++)
+    {
+        if (window->data.waylandData.staleBuffers[i].buffer != NULL)
+        {
+            wl_buffer_destroy(window->data.waylandData.staleBuffers[i].buffer);
+        }
+
+        window->data.waylandData.staleBuffers[i] = (UnixShmBuffer) { 0 };
+    }
+
+    if (window->data.waylandData.shmPool != NULL)
+    {
+        wl_shm_pool_destroy(window->data.waylandData.shmPool);
+        window->data.waylandData.shmPool = NULL;
+        window->data.waylandData.shmPoolSize = 0;
+    }
+
+    destroy_unix_framebuffer(&window->data.waylandData.framebuffer);
+}
+
+static bool retire_wayland_buffer(UnixWindow* window, UnixShmBuffer* buffer)
+{
+    for (int i = 0; i < UNIX_WAYLAND_STALE_BUFFER_COUNT; i++)
+    {
+        if (window->data.waylandData.staleBuffers[i].buffer == NULL)
+        {
+            window->data.waylandData.staleBuffers[i] = *buffer;
+            return true;
+        }
+    }
+
+    /* a compositor sitting on this many buffers gets the old behaviour, the buffer is dropped and its bytes reused */
+    log_warn("Too many Wayland buffers held across resizes");
+    return false;
+}
+
+static int find_wayland_first_frame(UnixWindow* window, size_t frameSize)
+{
+    int first = 0;
+    bool isClear = false;
+
+    /* first fit, every overlap moves the start just past the held buffer, so no gap is skipped */
+    while (!isClear)
+    {
+        size_t start = frameSize * (size_t)first;
+        size_t end = start + frameSize * UNIX_WAYLAND_BUFFER_COUNT;
+        isClear = true;
+
+        for (int i = 0; i < UNIX_WAYLAND_STALE_BUFFER_COUNT; i++)
+        {
+            UnixShmBuffer* stale = &window->data.waylandData.staleBuffers[i];
+
+            if (stale->buffer != NULL && stale->offset < end && start < stale->offset + stale->size)
+            {
+                first = (int)((stale->offset + stale->size + frameSize - 1) / frameSize);
+                isClear = false;
+            }
+        }
+    }
+
+    return first;
+}
+
+static int find_wayland_back_buffer(UnixWindow* window)
+{
+    int back = -1;
+
+    /* of the released buffers, the most recently shown needs the least redrawn */
+    for (int i = 0; i < UNIX_WAYLAND_BUFFER_COUNT; i++)
+    {
+        UnixShmBuffer* buffer = &window->data.waylandData.buffers[i];
+
+        if (buffer->buffer != NULL && !buffer->isBusy && (back < 0 || buffer->presentIndex > window->data.waylandData.buffers[back].presentIndex))
+        {
+            back = i;
+        }
+    }
+
+    return back;
+}
+
+static void present_wayland_buffer(UnixApp* app, UnixWindow* window, const WindowRect* rects, int count)
+{
+    struct wl_surface* surface = window->data.waylandData.surface;
+    int back = find_wayland_back_buffer(window);
+
+    if (back < 0)
+    {
+        return;
+    }
+
+    UnixShmBuffer* buffer = &window->data.waylandData.buffers[back];
+    wl_surface_attach(surface, buffer->buffer, 0, 0);
+
+    WindowRect whole = { 0, 0, window->data.waylandData.framebuffer.width, window->data.waylandData.framebuffer.height };
+    if (count == 0)
+    {
+        rects = &whole;
+        count = 1;
+    }
+
+    /* the compositor only uploads what is damaged, buffer coordinates skip any scale or transform */
+    bool hasDamageBuffer = wl_surface_get_version(surface) >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+    for (int i = 0; i < count; i++)
+    {
+        if (rects[i].width <= 0 || rects[i].height <= 0)
+        {
+            continue;
+        }
+
+        if (hasDamageBuffer)
+        {
+            wl_surface_damage_buffer(surface, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+        }
+        else
+        {
+            wl_surface_damage(surface, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+        }
+    }
+
+    wl_surface_commit(surface);
+
+    buffer->isBusy = true;
+    buffer->presentIndex = ++window->data.waylandData.presentCount;
+
+    wl_display_flush(app->data.waylandData.display);
+}
+
+static WindowRect unite_rects(WindowRect a, WindowRect b)
+{
+    if (a.width <= 0 || a.height <= 0)
+    {
+        return b;
+    }
+
+    if (b.width <= 0 || b.height <= 0)
+    {
+        return a;
+    }
+
+    int left = a.x < b.x ? a.x : b.x;
+    int top = a.y < b.y ? a.y : b.y;
+    int right = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int bottom = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+
+    return (WindowRect) { left, top, right - left, bottom - top };
+}
+
+static void mark_window_dirty(UnixWindow* window)
+{
+    window->needsRedraw = true;
+    window->damageRect = (WindowRect) { 0, 0, window->width, window->height };
+}
+
+static void handle_xdg_surface_configure(void* data, struct xdg_surface* xdgSurface, uint32_t serial)
+{
+    UnixWindow* window = (UnixWindow*)data;
+
+    xdg_surface_ack_configure(xdgSurface, serial);
+
+    int width = window->data.waylandData.pendingWidth;
+    int height = window->data.waylandData.pendingHeight;
+
+    /* a zero size leaves the choice to us */
+    if (width > 0 && height > 0 && (width != window->width || height != window->height))
+    {
+        window->width = width;
+        window->height = height;
+        window->configuredWidth = width;
+        window->configuredHeight = height;
+
+        if (window->data.waylandData.eglWindow != NULL)
+        {
+            wl_egl_window_resize(window->data.waylandData.eglWindow, width, height, 0, 0);
+        }
+
+        push_app_event(window->app, (AngeloEvent) {
+            .type = ANGELO_EVENT_WINDOW_RESIZE,
+            .window = (WindowHandle)window,
+            .data.resize = { width, height }
+        });
+    }
+
+    window->data.waylandData.isConfigured = true;
+    mark_window_dirty(window);
+
+    push_app_event(window->app, (AngeloEvent) {
+        .type = ANGELO_EVENT_WINDOW_EXPOSE,
+        .window = (WindowHandle)window,
+        .data.expose = window->damageRect
+    });
+}
+
+static void handle_toplevel_configure(void* data, struct xdg_toplevel* toplevel, int32_t width, int32_t height, struct wl_array* states)
+{
+    UnixWindow* window = (UnixWindow*)data;
+
+    window->data.waylandData.pendingWidth = width;
+    window->data.waylandData.pendingHeight = height;
+}
+
+static void handle_toplevel_close(void* data, struct xdg_toplevel* toplevel)
+{
+    UnixWindow* window = (UnixWindow*)data;
+
+    log_info("Window closed");
+    push_app_event(window->app, (AngeloEvent) { .type = ANGELO_EVENT_WINDOW_CLOSE, .window = (WindowHandle)window });
+    destroy_unix_window(window->app, window);
+}
+
+static void handle_frame_done(void* data, struct wl_callback* callback, uint32_t time)
+{
+    UnixWindow* window = (UnixWindow*)data;
+
+    wl_callback_destroy(callback);
+    window->data.waylandData.frameCallback = NULL;
+    atomic_store_explicit(&window->frameTime, time, memory_order_relaxed);
+
+    /* the compositor asks for a frame once the last one is on screen, so the gap between asks tracks the refresh */
+    uint64_t now = get_monotonic_nanos();
+    uint64_t refreshPeriod = window->frameTiming.refreshPeriod != 0 ? window->frameTiming.refreshPeriod : SOFTWARE_REFRESH_NANOS;
+    uint64_t gap = window->frameTiming.lastPresentTime != 0 ? now - window->frameTiming.lastPresentTime : 0;
+
+    if (gap != 0 && gap < refreshPeriod * 2)
+    {
+        refreshPeriod = (refreshPeriod * 7 + gap) / 8;
+    }
+
+    record_estimated_frame_timing(window, now, refreshPeriod);
+}
+
+static void handle_buffer_release(void* data, struct wl_buffer* buffer)
+{
+    UnixWindow* window = (UnixWindow*)data;
+    UnixApp* app = window->app;
+
+    /* the buffers belong to the render thread while it runs */
+    if (app->renderThread != NULL)
+    {
+        post_render_message(app, (UnixRenderMessage) { .type = UNIX_RENDER_MESSAGE_BUFFER_RELEASE, .window = window, .data.buffer = buffer });
+        return;
+    }
+
+    apply_buffer_release(window, buffer);
+}
+
+static uint32_t get_monotonic_millis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000);
+}
@@ -20,8 +20,10 @@
 ***************************************************************/
 
 #include <stdint.h>
+#include <stdatomic.h>
 #include "../util/util.h"
 #include "../app/app_unix.h"
+#include "../framebuffer/framebuffer_unix.h"
 
 #ifdef __unix
 
@@ -35,25 +37,169 @@
 ** MARK: CONSTANTS & MACRO
 ***************************************************************/
 
+#define UNIX_MAX_FRAMES_IN_FLIGHT 4
+
+/* frames of damage kept to bring older back buffers up to date */
+#define UNIX_DAMAGE_HISTORY 4
+
+/* software rendered Xorg windows draw into one image while the server reads the other */
+#define UNIX_XORG_IMAGE_COUNT 2
+
+/* a third buffer keeps drawing going while the compositor holds one and the screen shows another */
+#define UNIX_WAYLAND_BUFFER_COUNT 3
+
+/* buffers from before a resize that the compositor still holds, two generations' worth */
+#define UNIX_WAYLAND_STALE_BUFFER_COUNT (UNIX_WAYLAND_BUFFER_COUNT * 2)
+
 /***************************************************************
 ** MARK: TYPEDEFS
 ***************************************************************/
 
 #ifdef __unix
 
-    typedef struct {
+    typedef struct
+    {
+        struct wl_buffer* buffer;
+
+        /* the bytes of the pool the buffer covers */
+        size_t offset;
+        size_t size;
+
+        /* attached and not yet released by the compositor */
+        bool isBusy;
+
+        /* presentCount when the buffer was last attached, 0 if it never was */
+        uint64_t presentIndex;
+    } UnixShmBuffer;
+
+    typedef struct UnixWindow {
         UnixAppType appType;
 
         const char* title;
 
+        /* owning app, needed by protocol callbacks */
+        UnixApp* app;
+
+        /* position in the app's window registry */
+        uintptr_t registryKey;
+        size_t registryIndex;
+
+        int width;
+        int height;
+
+        /* size last reported through the event queue, owned by the event thread */
+        int configuredWidth;
+        int configuredHeight;
+        bool hasPendingResize;
+
+        /* sequence number + 1 of the motion and resize events this window has queued, 0 for none */
+        uint64_t motionEventSeq;
+        uint64_t resizeEventSeq;
+
+        /* set when the window contents must be redrawn */
+        bool needsRedraw;
+
+        /* bounding box of everything invalidated since the last frame */
+        WindowRect damageRect;
+
+        /* time of the last presented frame in milliseconds, written by the rendering thread and read from any */
+        atomic_uint frameTime;
+
+        /* swap interval, applied by the rendering thread on the next swap while dirty */
+        int swapInterval;
+        bool isSwapIntervalDirty;
+
+        /* set when nothing in the driver enforces the interval and swaps sleep instead */
+        bool isSwapLimited;
+        uint64_t lastSwapNanos;
+
+        /* bounds of what each recently swapped frame changed, newest first */
+        WindowRect damageHistory[UNIX_DAMAGE_HISTORY];
+        int damageHistoryCount;
+
+        /* what cpu clears are limited to during a repaint, empty for the whole window */
+        WindowRect clipRect;
+
+        /* one fence per swapped frame the gpu may not have finished, oldest first */
+        int maxFramesInFlight;
+        int frameFenceCount;
+        GLsync frameFences[UNIX_MAX_FRAMES_IN_FLIGHT];
+
+        /* written by the rendering thread, odd timingSeq while an update is in progress */
+        atomic_uint timingSeq;
+        WindowFrameTiming frameTiming;
+
+        /* the window surface (a pbuffer for headless windows) and context when the app renders through EGL */
+        EGLSurface eglSurface;
+        EGLContext eglContext;
+
+        /* set by the render thread once it has released the window's gl resources */
+        bool isRetired;
+        struct UnixWindow* nextRetired;
+
         union 
         {
             struct
             {
                 Window rawHandle;
                 Atom deleteMessage;
+
+                /* NULL when the app renders through EGL */
                 GLXContext glContext;
+
+                /* swap counts for GLX_OML_sync_control, and the vblank the last swap was aimed at */
+                bool isSbcSynced;
+                int64_t issuedSbc;
+                int64_t presentedSbc;
+                int64_t targetMsc;
+
+                /* cpu framebuffers when the app renders in software, and the images describing them at the current size */
+                UnixFramebuffer framebuffers[UNIX_XORG_IMAGE_COUNT];
+                XImage* images[UNIX_XORG_IMAGE_COUNT];
+                XShmSegmentInfo shmSegments[UNIX_XORG_IMAGE_COUNT];
+                GC gc;
+
+                /* puts the server hasn't sent ShmCompletion for, the image can't be drawn into until they finish */
+                int pendingPuts[UNIX_XORG_IMAGE_COUNT];
+
+                /* presentCount when each image was last put, for buffer age */
+                uint64_t imagePresents[UNIX_XORG_IMAGE_COUNT];
+                uint64_t presentCount;
+                int backImage;
             } xorgData;
+
+            struct
+            {
+                struct wl_surface* surface;
+                struct xdg_surface* xdgSurface;
+                struct xdg_toplevel* toplevel;
+                struct zxdg_toplevel_decoration_v1* decoration;
+                struct wl_egl_window* eglWindow;
+
+                /* outstanding wl_surface.frame request, rendering waits for it */
+                struct wl_callback* frameCallback;
+
+                /* size requested by the last toplevel configure */
+                int pendingWidth;
+                int pendingHeight;
+                bool isConfigured;
+
+                /* cpu framebuffers when the app has no EGL display, one frame per buffer of a memfd pool */
+                UnixFramebuffer framebuffer;
+                struct wl_shm_pool* shmPool;
+                size_t shmPoolSize;
+                UnixShmBuffer buffers[UNIX_WAYLAND_BUFFER_COUNT];
+
+                /* replaced by a resize while still held, their bytes stay untouched until the release */
+                UnixShmBuffer staleBuffers[UNIX_WAYLAND_STALE_BUFFER_COUNT];
+                uint64_t presentCount;
+            } waylandData;
+
+            struct
+            {
+                /* RGBA8 pixels when the app has no EGL display */
+                UnixFramebuffer framebuffer;
+            } headlessData;
         } data;
         
     } UnixWindow;
@@ -64,4 +210,37 @@
 ** MARK: FUNCTION DEFS
 ***************************************************************/
 
+#ifdef __unix
+
+    /* with a render thread running this only retires the window, it is freed once the thread lets go */
+    void destroy_unix_window(UnixApp* app, UnixWindow* window);
+
+    /* destroys the window's surface and context, on whichever thread renders it */
+    void release_window_gl(UnixApp* app, UnixWindow* window);
+
+    /* resizes the window, deferred to the render thread when one is running */
+    void resize_unix_window(UnixApp* app, UnixWindow* window, int width, int height);
+
+    /* render side of invalidate_rect and resize_unix_window */
+    void apply_window_damage(UnixWindow* window, WindowRect rect);
+    void apply_window_resize(UnixWindow* window, int width, int height);
+    void apply_swap_interval(UnixWindow* window, int interval);
+    void apply_max_frames_in_flight(UnixWindow* window, int count);
+    void apply_image_release(UnixWindow* window, ShmSeg segment);
+    void apply_buffer_release(UnixWindow* window, struct wl_buffer* buffer);
+
+    /* the server has finished reading one of the window's images, called from the event thread */
+    void release_xorg_image(UnixApp* app, UnixWindow* window, ShmSeg segment);
+
+    /* draws and presents the window if it has damage and may start a frame */
+    void render_unix_window(UnixApp* app, UnixWindow* window);
+
+    /* binds the window's context and drawable unless they are already current */
+    void make_window_current(UnixApp* app, UnixWindow* window);
+
+    /* false while the compositor hasn't asked for the next frame */
+    bool is_window_ready_for_frame(UnixWindow* window);
+
+#endif
+
 #endif /* WIN_XORG_H */
\ No newline at end of file
@@ -116,7 +116,7 @@ fatal_error(char *msg)
 ** MARK: PUBLIC FUNCTIONS
 ***************************************************************/
 
-WindowHandle_opt create_window(int width, int height, const char* title)
+WindowHandle_opt create_window(AppHandle app, int width, int height, const char* title)
 {
     
     ensure_window_class();
@@ -147,7 +147,35 @@ WindowHandle_opt create_window(int width, int height, const char* title)
     ShowWindow(hwnd, SW_SHOW);
     UpdateWindow(hwnd);
 
-    return (WindowHandle_opt) { .value = (intptr_t)0, .is_some = true };
+    return (WindowHandle_opt) { .value = (intptr_t)hwnd, .is_some = true };
+}
+
+void invalidate_window(AppHandle app, WindowHandle handle)
+{
+    HWND hwnd = (HWND)handle;
+
+    if (hwnd == NULL)
+    {
+        log_error("Invalid window handle");
+        return;
+    }
+
+    /* windows merges the update region and sends a single WM_PAINT */
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+void invalidate_rect(AppHandle app, WindowHandle handle, WindowRect rect)
+{
+    HWND hwnd = (HWND)handle;
+
+    if (hwnd == NULL)
+    {
+        log_error("Invalid window handle");
+        return;
+    }
+
+    RECT region = { rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+    InvalidateRect(hwnd, &region, FALSE);
 }
 
 /***************************************************************
@@ -0,0 +1,205 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <angelo.h>
+
+/* post -> execute latency of post_app_task with many producer threads */
+
+#define TASK_PRODUCERS 16
+#define TASKS_PER_PRODUCER 20000
+#define TASK_TOTAL (TASK_PRODUCERS * TASKS_PER_PRODUCER)
+
+typedef struct {
+    AppHandle app;
+    long pauseNanos;
+} TaskProducer;
+
+static uint64_t taskLatencies[TASK_TOTAL];
+static size_t taskCount;
+static atomic_int readyProducers;
+
+static uint64_t get_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_task(AppHandle app, void* userData) {
+    taskLatencies[taskCount++] = get_nanos() - (uint64_t)(uintptr_t)userData;
+}
+
+static void* produce_tasks(void* data) {
+    TaskProducer* producer = data;
+
+    /* start together so the queue is contended from the first post */
+    atomic_fetch_add(&readyProducers, 1);
+    while (atomic_load(&readyProducers) < TASK_PRODUCERS) {
+    }
+
+    for (int i = 0; i < TASKS_PER_PRODUCER; i++) {
+        post_app_task(producer->app, run_task, (void*)(uintptr_t)get_nanos());
+
+        if (producer->pauseNanos > 0) {
+            struct timespec pause = { 0, producer->pauseNanos };
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+static void bench_tasks(AppHandle app, const char* name, long pauseNanos) {
+    pthread_t threads[TASK_PRODUCERS];
+    TaskProducer producer = { app, pauseNanos };
+    AngeloEvent events[64];
+
+    taskCount = 0;
+    atomic_store(&readyProducers, 0);
+
+    uint64_t start = get_nanos();
+
+    for (int i = 0; i < TASK_PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, produce_tasks, &producer);
+    }
+
+    while (taskCount < TASK_TOTAL) {
+        wait_events(app, events, 64, 100);
+    }
+
+    uint64_t elapsed = get_nanos() - start;
+
+    for (int i = 0; i < TASK_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    qsort(taskLatencies, TASK_TOTAL, sizeof(uint64_t), compare_u64);
+
+    printf("%-10s %9.0f tasks/s   p50 %7.1f us   p99 %7.1f us   p99.9 %8.1f us   max %8.1f us\n",
+        name,
+        TASK_TOTAL / (elapsed / 1e9),
+        taskLatencies[TASK_TOTAL / 2] / 1e3,
+        taskLatencies[TASK_TOTAL * 99 / 100] / 1e3,
+        taskLatencies[TASK_TOTAL * 999 / 1000] / 1e3,
+        taskLatencies[TASK_TOTAL - 1] / 1e3);
+}
+
+/* full vs incremental layout of a ~50k element tree */
+
+#define LAYOUT_PANELS 50
+#define LAYOUT_ROWS_PER_PANEL 100
+#define LAYOUT_LABELS_PER_ROW 9
+#define LAYOUT_FULL_RUNS 20
+#define LAYOUT_EDITS 10000
+
+static uint64_t layoutTimes[LAYOUT_EDITS];
+
+/* even panels are fixed size layout boundaries, odd ones fit their rows */
+static ElementTreeHandle build_layout_tree(ElementHandle* boundaryLabel, ElementHandle* fittedLabel) {
+    ElementTreeHandle tree = create_element_tree().value;
+    ElementHandle root = get_root_element(tree);
+
+    set_element_layout(tree, root, (ElementLayout) { .direction = ELEMENT_LAYOUT_ROW, .width = ELEMENT_SIZE_AUTO, .height = ELEMENT_SIZE_AUTO, .gap = 4 });
+
+    for (int p = 0; p < LAYOUT_PANELS; p++) {
+        ElementHandle panel = create_element(tree, root).value;
+        float size = p % 2 == 0 ? 400.0f : ELEMENT_SIZE_AUTO;
+        set_element_layout(tree, panel, (ElementLayout) { .direction = ELEMENT_LAYOUT_COLUMN, .width = size, .height = size, .padding = 8, .gap = 2 });
+
+        for (int r = 0; r < LAYOUT_ROWS_PER_PANEL; r++) {
+            ElementHandle row = create_element(tree, panel).value;
+            set_element_layout(tree, row, (ElementLayout) { .direction = ELEMENT_LAYOUT_ROW, .width = ELEMENT_SIZE_AUTO, .height = ELEMENT_SIZE_AUTO, .gap = 4 });
+
+            for (int l = 0; l < LAYOUT_LABELS_PER_ROW; l++) {
+                ElementHandle label = create_element(tree, row).value;
+                set_element_content_size(tree, label, (ElementSize) { 40.0f + (float)l, 16.0f });
+
+                if (r == LAYOUT_ROWS_PER_PANEL / 2 && l == 0) {
+                    *(p % 2 == 0 ? boundaryLabel : fittedLabel) = label;
+                }
+            }
+        }
+    }
+
+    return tree;
+}
+
+static void bench_layout_edits(ElementTreeHandle tree, const char* name, ElementHandle label) {
+    for (int i = 0; i < LAYOUT_EDITS; i++) {
+        /* a text change that resizes the label */
+        set_element_content_size(tree, label, (ElementSize) { 40.0f + (float)(i % 7), 16.0f });
+
+        uint64_t start = get_nanos();
+        layout_element_tree(tree, 1920, 1080);
+        layoutTimes[i] = get_nanos() - start;
+    }
+
+    qsort(layoutTimes, LAYOUT_EDITS, sizeof(uint64_t), compare_u64);
+
+    printf("%-10s p50 %7.2f us   p99 %7.2f us   max %8.2f us\n",
+        name,
+        layoutTimes[LAYOUT_EDITS / 2] / 1e3,
+        layoutTimes[LAYOUT_EDITS * 99 / 100] / 1e3,
+        layoutTimes[LAYOUT_EDITS - 1] / 1e3);
+}
+
+static void bench_layout_full(const char* name, uint32_t threadCount) {
+    ElementHandle boundaryLabel, fittedLabel;
+    uint64_t total = 0;
+
+    for (int i = 0; i < LAYOUT_FULL_RUNS; i++) {
+        ElementTreeHandle tree = build_layout_tree(&boundaryLabel, &fittedLabel);
+        set_element_layout_threads(tree, threadCount);
+
+        uint64_t start = get_nanos();
+        layout_element_tree(tree, 1920, 1080);
+        total += get_nanos() - start;
+
+        destroy_element_tree(tree);
+    }
+
+    printf("%-10s mean %7.2f us   %u threads\n", name, total / (double)LAYOUT_FULL_RUNS / 1e3, threadCount);
+}
+
+static void bench_layout() {
+    ElementHandle boundaryLabel, fittedLabel;
+    ElementTreeHandle tree = build_layout_tree(&boundaryLabel, &fittedLabel);
+
+    printf("layout_element_tree, %zu elements\n", get_element_count(tree));
+
+    bench_layout_full("full", 1);
+    bench_layout_full("parallel", (uint32_t)sysconf(_SC_NPROCESSORS_ONLN));
+
+    layout_element_tree(tree, 1920, 1080);
+    bench_layout_edits(tree, "boundary", boundaryLabel);
+    bench_layout_edits(tree, "fitted", fittedLabel);
+
+    destroy_element_tree(tree);
+}
+
+int main() {
+    AppConfig config = { .backend = APP_BACKEND_HEADLESS, .softwareRendering = true };
+
+    AppHandle_opt app = create_app_with_config("Angelo Bench", config);
+    if (!app.is_some) {
+        printf("Failed to create app!\n");
+        return -1;
+    }
+
+    printf("post_app_task, %d producers x %d tasks\n", TASK_PRODUCERS, TASKS_PER_PRODUCER);
+    bench_tasks(app.value, "saturated", 0);
+    bench_tasks(app.value, "paced", 20000);
+
+    bench_layout();
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <angelo.h>
+
+/* incremental layout has to match a forced full relayout after random edits */
+
+#define LAYOUT_CHECK_ELEMENTS 3000
+#define LAYOUT_CHECK_EDITS 2000
+#define LAYOUT_CHECK_INTERVAL 50
+
+static ElementHandle checkElements[LAYOUT_CHECK_ELEMENTS];
+static ElementRect checkRects[LAYOUT_CHECK_ELEMENTS];
+
+static float random_layout_size() {
+    return rand() % 2 ? ELEMENT_SIZE_AUTO : (float)(50 + rand() % 100);
+}
+
+static int check_layout(uint32_t threadCount) {
+    ElementTreeHandle tree = create_element_tree().value;
+    int count = 0, mismatches = 0;
+
+    set_element_layout_threads(tree, threadCount);
+    srand(7);
+
+    checkElements[count++] = get_root_element(tree);
+
+    for (int i = 1; i < LAYOUT_CHECK_ELEMENTS; i++) {
+        ElementHandle element = create_element(tree, checkElements[rand() % count]).value;
+        checkElements[count++] = element;
+
+        set_element_layout(tree, element, (ElementLayout) {
+            .direction = (ElementLayoutDirection)(rand() % 3),
+            .width = random_layout_size(),
+            .height = random_layout_size(),
+            .grow = rand() % 4 == 0 ? (float)(1 + rand() % 3) : 0,
+            .padding = (float)(rand() % 4),
+            .gap = (float)(rand() % 3)
+        });
+        set_element_content_size(tree, element, (ElementSize) { (float)(rand() % 60), (float)(rand() % 30) });
+    }
+
+    for (int edit = 0; edit < LAYOUT_CHECK_EDITS; edit++) {
+        ElementHandle element = checkElements[1 + rand() % (count - 1)];
+        if (!is_element_valid(tree, element)) {
+            continue;
+        }
+
+        ElementLayout layout = get_element_layout(tree, element);
+
+        switch (rand() % 5) {
+            case 0:
+                set_element_content_size(tree, element, (ElementSize) { (float)(rand() % 60), (float)(rand() % 30) });
+                break;
+            case 1:
+                layout.width = random_layout_size();
+                layout.grow = rand() % 3 == 0 ? 1 : 0;
+                set_element_layout(tree, element, layout);
+                break;
+            case 2: {
+                /* queues the element if it is a boundary, then stops it being one before the next pass */
+                ElementHandle_opt child = get_element_first_child(tree, element);
+                if (child.is_some) {
+                    set_element_content_size(tree, child.value, (ElementSize) { (float)(rand() % 60), (float)(rand() % 30) });
+                }
+                layout.width = ELEMENT_SIZE_AUTO;
+                set_element_layout(tree, element, layout);
+                break;
+            }
+            case 3: {
+                ElementHandle_opt child = create_element(tree, element);
+                if (child.is_some && count < LAYOUT_CHECK_ELEMENTS) {
+                    checkElements[count++] = child.value;
+                }
+                break;
+            }
+            default:
+                if (edit % 10 == 0) {
+                    destroy_element(tree, element);
+                }
+                break;
+        }
+
+        float width = (float)(800 + (edit / 100) % 3 * 10);
+        layout_element_tree(tree, width, 600);
+
+        if (edit % LAYOUT_CHECK_INTERVAL != 0) {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (is_element_valid(tree, checkElements[i])) {
+                checkRects[i] = get_element_rect(tree, checkElements[i]);
+            }
+        }
+
+        /* setting every layout again dirties everything */
+        for (int i = 0; i < count; i++) {
+            if (is_element_valid(tree, checkElements[i])) {
+                set_element_layout(tree, checkElements[i], get_element_layout(tree, checkElements[i]));
+            }
+        }
+
+        layout_element_tree(tree, width, 600);
+
+        for (int i = 0; i < count; i++) {
+            if (is_element_valid(tree, checkElements[i])) {
+                ElementRect rect = get_element_rect(tree, checkElements[i]);
+                mismatches += memcmp(&rect, &checkRects[i], sizeof(ElementRect)) != 0;
+            }
+        }
+    }
+
+    destroy_element_tree(tree);
+
+    printf("%-10s %d mismatches   %u threads\n", "check", mismatches, threadCount);
+
+    return mismatches;
+}
+
+int main() {
+    printf("layout_element_tree, incremental vs full\n");
+    int mismatches = check_layout(1) + check_layout(4) + check_layout(8);
+
+    return mismatches == 0 ? 0 : -1;
+}